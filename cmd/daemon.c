@@ -0,0 +1,227 @@
+/*
+ Copyright 2017 D-Wave Systems Inc.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+// The -D server mode of qbsolv: QUBOs in the .qubo format arrive one after the other on a stream,
+// the standard input or a connection to a Unix domain socket, and the result of each is written
+// back to the same stream as soon as it is solved.  The process, the dw connection, the solution
+// tables and the scratch memory and threads of the solver stay up between QUBOs, so a QUBO costs
+// its parsing and its solve only.
+
+#include "daemon.h"
+#include "extern.h"
+#include "macros.h"
+#include "readqubo.h"
+#include "solver.h"
+#include "util.h"
+
+#include <errno.h>
+#include <signal.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// The seconds a connection may go without sending or reading before it is dropped, so a stalled
+// client holds up the ones waiting behind it no longer than that
+static const int clientTimeout = 30;
+
+// The largest QUBO a client may send, in variables and in entries of the .qubo format, so that no
+// QUBO makes the server run out of memory and exit under the other clients
+static const int maxJobNodes = 20000;
+static const int maxJobEntries = 10000000;
+
+// What the daemon keeps from one QUBO to the next
+typedef struct daemon_t {
+    qbsolv_context_t *ctx;  // the options of every solve
+    parameters_t *param;
+    const char *layout;  // -L, NULL for the layout the density of each QUBO calls for
+    int QLEN;
+    solver_rng_t rng;  // the seeds of the solves, drawn from -r in the order the QUBOs arrive
+    // the solution tables and the workspace of the solves, grown to the largest QUBO seen
+    int capacity;
+    int8_t *solution_bits;  // the rows of solution_list
+    int8_t **solution_list;
+    double *energy_list;
+    int *solution_counts;
+    int *Qindex;
+    solver_workspace_t *work;
+} daemon_t;
+
+static bool cancelled(const daemon_t *d) { return d->ctx->cancel != NULL && *d->ctx->cancel; }
+
+// Solve the QUBO read last and write its best solution and energy to out
+static void solve_job(daemon_t *d, FILE *out) {
+    qubo_matrix_t qubo;
+    if (build_qubo(d->layout, false, &qubo) != 0) {
+        fprintf(out, "error: -L integer needs integer coefficients that fit in 32 bits\n");
+        return;
+    }
+    if (qubo.size > d->capacity) {
+        free(d->solution_bits);
+        solver_workspace_free(d->work);
+        d->work = NULL;
+        d->capacity = 0;
+        // a failed allocation fails this QUBO only, the next one tries again
+        if (GETMEM(d->solution_bits, int8_t, (size_t)(d->QLEN + 1) * qubo.size) == NULL) {
+            fprintf(out, "error: out of memory for the solutions of a QUBO of %d variables\n", qubo.size);
+            free_qubo(&qubo);
+            return;
+        }
+        for (int i = 0; i <= d->QLEN; i++) d->solution_list[i] = d->solution_bits + (size_t)i * qubo.size;
+        d->capacity = qubo.size;
+        d->work = solver_workspace_create(d->capacity, d->param->sub_size);
+    }
+
+    // each solve prints nothing of its own, the result goes back as two lines
+    qbsolv_context_t ctx = *d->ctx;
+    ctx.quiet = true;
+    ctx.out = out;
+    ctx.num_outputs = 0;
+    solver_rng_t *caller_rng = solver_rand_stream(&d->rng);
+    ctx.seed = solver_rand64();
+    solver_rand_stream(caller_rng);
+    parameters_t param = *d->param;
+    solve_qubo_workspace(&ctx, &qubo, d->solution_list, d->energy_list, d->solution_counts, d->Qindex, d->QLEN, &param,
+                         d->work);
+
+    double sign = ctx.find_max ? 1.0 : -1.0;
+    int8_t *best = d->solution_list[d->Qindex[0]];
+    for (int i = 0; i < qubo.size; i++) fprintf(out, "%d", best[i]);
+    fprintf(out, "\n%8.5f Energy of solution\n", d->energy_list[d->Qindex[0]] * sign);
+    free_qubo(&qubo);
+}
+
+// Answer the QUBOs of in on out until in ends, a bad QUBO is answered with a line "error: ..."
+//
+// A read that fails, as one cut short by an interrupt or one past the timeout of a connection,
+// ends the stream too.
+static void serve_stream(daemon_t *d, FILE *in, FILE *out) {
+    char message[256];
+    int read;
+    while (!cancelled(d) && (read = read_qubo_job(in, maxJobNodes, maxJobEntries, message, sizeof(message))) != 0) {
+        if (cancelled(d)) break;
+        if (read < 0) {
+            fprintf(out, "error: %s\n", message);
+        } else {
+            solve_job(d, out);
+        }
+        fflush(out);
+        if (ferror(in) || ferror(out)) break;
+    }
+}
+
+#ifndef _WIN32
+// Serve the connections to the Unix domain socket at path one after the other, each until it ends
+// or stalls for clientTimeout seconds
+static void serve_socket(daemon_t *d, const char *path) {
+    struct sockaddr_un address;
+    int server;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "\n\t Error - socket path too long \"%s\"\n\n", path);
+        exit(9);
+    }
+    strcpy(address.sun_path, path);
+    unlink(path);  // left over from an earlier run
+    if ((server = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(server, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(server, 16) != 0) {
+        fprintf(stderr, "\n\t Error - can't listen on socket \"%s\"\n\n", path);
+        exit(9);
+    }
+    signal(SIGPIPE, SIG_IGN);  // a client that leaves early costs its own results only
+
+    while (!cancelled(d)) {
+        struct pollfd waiting = {server, POLLIN, 0};
+        if (poll(&waiting, 1, 200) <= 0) continue;  // looks at the cancel flag every 200 ms
+        int client = accept(server, NULL, NULL);
+        if (client < 0) continue;
+        struct timeval timeout = {clientTimeout, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int client_out = dup(client);
+        FILE *in = fdopen(client, "r");
+        FILE *out = client_out < 0 ? NULL : fdopen(client_out, "w");
+        if (in == NULL || out == NULL) {
+            fprintf(stderr, "\n\t Error - can't serve a connection: %s\n\n", strerror(errno));
+            if (in != NULL) {
+                fclose(in);
+            } else {
+                close(client);
+            }
+            if (out != NULL) {
+                fclose(out);
+            } else if (client_out >= 0) {
+                close(client_out);
+            }
+            continue;
+        }
+        serve_stream(d, in, out);
+        fclose(in);
+        fclose(out);
+    }
+    close(server);
+    unlink(path);
+}
+#endif
+
+//  solve the QUBOs sent to the Unix domain socket at path, or to the standard input when path is
+//  "-", writing the results to ctx->out
+//
+//  @param ctx the options of every solve, a solve is cut short and the daemon stops when its
+//      cancel flag is set
+//  @param param Other parameters to the solve method, the same for every QUBO
+//  @param layout the layout of every QUBO, NULL for the one its density calls for
+//  @param QLEN Number of entries in the solution table
+//  @param path the socket, or "-"
+void run_daemon(qbsolv_context_t *ctx, parameters_t *param, const char *layout, int QLEN, const char *path) {
+    daemon_t d;
+    d.ctx = ctx;
+    d.param = param;
+    d.layout = layout;
+    d.QLEN = QLEN;
+    solver_rng_seed(&d.rng, ctx->seed);
+    d.capacity = 0;
+    d.solution_bits = NULL;
+    if (GETMEM(d.solution_list, int8_t *, QLEN + 1) == NULL) BADMALLOC
+    d.work = NULL;
+    if (GETMEM(d.energy_list, double, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(d.solution_counts, int, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(d.Qindex, int, QLEN + 1) == NULL) BADMALLOC
+
+    if (strcmp(path, "-") == 0) {
+        serve_stream(&d, stdin, ctx->out);
+    } else {
+#ifndef _WIN32
+        serve_socket(&d, path);
+#else
+        fprintf(stderr, "\n\t Error - Unix domain sockets are not supported, use -D -\n\n");
+        exit(9);
+#endif
+    }
+
+    free(d.solution_bits);
+    free(d.solution_list);
+    free(d.energy_list);
+    free(d.solution_counts);
+    free(d.Qindex);
+    solver_workspace_free(d.work);
+}
@@ -0,0 +1,31 @@
+/*
+ Copyright 2017 D-Wave Systems Inc.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+#pragma once
+
+#include "qbsolv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  solve the QUBOs sent to the Unix domain socket at path, or to the standard input when path is
+//  "-", one after the other until the input ends or ctx->cancel is set, writing the result of each
+//  back as soon as it is found
+void run_daemon(qbsolv_context_t *ctx, parameters_t *param, const char *layout, int QLEN, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,11 +21,13 @@
 #endif // _WIN32
 
 
+#include "daemon.h"
 #include "dwsolv.h"
 #include "qbsolv.h"
 #include "readqubo.h"
 #include "util.h"
 
+#include <signal.h>
 
 void print_help(void);
 void print_qubo_format(void);
@@ -37,7 +39,6 @@ FILE *solution_input_;
 int maxNodes_, nCouplers_, nNodes_, findMax_, numsolOut_;
 int Verbose_, TargetSet_, WriteMatrix_, Tlist_;
 char *outFileNm_, pgmName_[16], algo_[4];
-double **val;
 double Target_, Time_;
 struct nodeStr_ *nodes_;
 struct nodeStr_ *couplers_;
@@ -52,6 +53,47 @@ struct nodeStr_ *couplers_;
 
 const int defaultRepeats = 50;
 
+// set by SIGINT or SIGTERM, the solve then stops and prints the best solution it has
+static volatile sig_atomic_t interrupted_ = 0;
+
+static void interrupt_handler(int sig) {
+    interrupted_ = 1;
+#ifdef _WIN32
+    signal(sig, SIG_DFL);  // a second one ends the program at once
+#else
+    (void)sig;
+#endif
+}
+
+// Read the QUBO of inFileName into qubo, in the given layout, or when layout is NULL the one its
+// density calls for, see build_qubo
+static void load_qubo(const char *inFileName, const char *layout, bool write_matrix, qubo_matrix_t *qubo) {
+    FILE *inFile;
+    if ((inFile = fopen(inFileName, "r")) == NULL) {
+        fprintf(stderr,
+                "\n\t Error - can't find/open file "
+                "\"%s\"\n\n",
+                inFileName);
+        exit(9);
+    }
+    int errorCount = read_qubo(inFileName, inFile);  // read in the QUBO from file
+    fclose(inFile);
+
+    if ((errorCount > 0)) {
+        fprintf(stderr,
+                "\n\t%d Input error(s) on file \"%s\"\n\n"
+                "\t%s has been stopped.\n\tThere is a description "
+                "of the .qubo file format: use %s -q to print it\n\n",
+                errorCount, inFileName, pgmName_, pgmName_);
+        exit(1);
+    }
+
+    if (build_qubo(layout, write_matrix, qubo) != 0) {
+        fprintf(stderr, "\n Error --  -L integer needs integer coefficients that fit in 32 bits, %s\n", inFileName);
+        exit(9);
+    }
+}
+
 int main(int argc, char *argv[]) {
     /*
      *  Initialize global variables, set up data structures,
@@ -60,27 +102,23 @@ int main(int argc, char *argv[]) {
      */
 
     parameters_t param = default_parameters();
+    qbsolv_context_t context = default_context();  // the run options, algorithm "o", minimum, stdout, ...
 
     bool use_dwave = false;
+    char *layout = NULL;  // storage layout of the QUBO, chosen from the density when not given
 
     extern char *optarg;
     extern int optind, optopt, opterr;
 
-    char *inFileName = NULL;
-    FILE *inFile = NULL;
+    char **inFileNames = NULL;  // -i, and the files a -b manifest names
+    int numInFiles = 0;
+    FILE *manifest;
+    bool batch = false;  // independent QUBOs, solved -j at a time
+    char *daemonPath = NULL;  // -D, the socket the QUBOs to solve arrive on, "-" for the standard input
+    char *solutionFileName = NULL;  // -s, the solutions to warm start from
+    solution_input_ = NULL;
 
     strcpy(pgmName_, "qbsolv");
-    findMax_ = false;
-    Verbose_ = 0;
-    strcpy(algo_, "o");  // algorithm default
-
-    WriteMatrix_ = false;
-    outFile_ = stdout;
-    TargetSet_ = false;
-    Time_ = 2592000;  // the maximum runtime of the algorithm in seconds before timeout (2592000 = a month's worth of
-                      // seconds)
-    Tlist_ = -1;      // tabu list length  -1 signals go with defaults
-    int64_t seed = 17932241798878;
     int errorCount = 0;
 
     static struct option longopts[] = {{"help", no_argument, NULL, 'h'},
@@ -99,6 +137,12 @@ int main(int argc, char *argv[]) {
                                        {"tlist", required_argument, NULL, 'l'},
                                        {"seed", required_argument, NULL, 'r'},
                                        {"Algo", required_argument, NULL, 'a'},
+                                       {"layout", required_argument, NULL, 'L'},
+                                       {"threads", required_argument, NULL, 'j'},
+                                       {"independentGroups", no_argument, NULL, 'g'},
+                                       {"islands", required_argument, NULL, 'I'},
+                                       {"batch", required_argument, NULL, 'b'},
+                                       {"daemon", required_argument, NULL, 'D'},
                                        {NULL, no_argument, NULL, 0}};
 
     int opt, option_index = 0;
@@ -107,11 +151,12 @@ int main(int argc, char *argv[]) {
         use_dwave = true;
     }
 
-    while ((opt = getopt_long(argc, argv, "Hhi:o:v:VS:T:l:n:wmo:t:qr:a:", longopts, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "Hhi:o:v:VS:T:l:n:wmo:t:qr:a:L:j:gI:s:b:D:", longopts,
+                              &option_index)) != -1) {
         switch (opt) {
             case 'a':
-                strcpy(algo_, optarg);  // algorithm copied off of command line -a option
-                switch (algo_[0]) {
+                strncpy(context.algo, optarg, sizeof(context.algo) - 1);  // algorithm off of command line -a option
+                switch (context.algo[0]) {
                     case 'o':
                         // Original Dwave algorithm
                         break;
@@ -119,44 +164,92 @@ int main(int argc, char *argv[]) {
                         // choose "Solution diversity"
                         break;
                     default: /* unknown */
-                        printf(" Unknown Algorithm choice: options are o:d cmdline had %s \n", algo_);
+                        printf(" Unknown Algorithm choice: options are o:d cmdline had %s \n", context.algo);
                         exit(9);
                         break;
                 }
                 break;
-            case 'H':
-            case 'h':
-                print_help();
-                exit(0);
-            case 'i':
-                inFileName = optarg;
-                if ((inFile = fopen(inFileName, "r")) == NULL) {
+            case 'b':
+                if ((manifest = fopen(optarg, "r")) == NULL) {
                     fprintf(stderr,
                             "\n\t Error - can't find/open file "
                             "\"%s\"\n\n",
                             optarg);
                     exit(9);
                 }
+                read_manifest(optarg, manifest, &inFileNames, &numInFiles);
+                fclose(manifest);
+                batch = true;
+                break;
+            case 'D':
+                daemonPath = optarg;
+                break;
+            case 'g':
+                param.independent_groups = true;  // no two sub problems solved at the same time share a coupler
+                break;
+            case 'H':
+            case 'h':
+                print_help();
+                exit(0);
+            case 'I':
+                param.num_islands = strtol(optarg, &chx, 10);  // outer loops run at the same time
+                if (param.num_islands < 1) {
+                    fprintf(stderr, "\n Error --  islands must be 1 or greater.  -I %d\n ", param.num_islands);
+                    ++errorCount;
+                }
+                break;
+            case 'i':
+                if ((inFileNames = (char **)realloc(inFileNames, (numInFiles + 1) * sizeof(char *))) == NULL) BADMALLOC
+                if (GETMEM(inFileNames[numInFiles], char, strlen(optarg) + 1) == NULL) BADMALLOC
+                strcpy(inFileNames[numInFiles++], optarg);
+                break;
+            case 'j':
+                param.num_threads = strtol(optarg, &chx, 10);  // sub problems solved at the same time
+                if (param.num_threads < 1) {
+                    fprintf(stderr, "\n Error --  threads must be 1 or greater.  -j %d\n ", param.num_threads);
+                    ++errorCount;
+                }
                 break;
             case 'l':
-                Tlist_ = strtol(optarg, &chx, 10);  // this sets the length of the tabu list
+                context.tabu_tenure = strtol(optarg, &chx, 10);  // this sets the length of the tabu list
+                break;
+            case 'L':
+                layout = optarg;  // storage layout of the QUBO matrix
+                if (strcmp(layout, "dense") != 0 && strcmp(layout, "sparse") != 0 &&
+                    strcmp(layout, "symmetric") != 0 && strcmp(layout, "float") != 0 &&
+                    strcmp(layout, "integer") != 0) {
+                    fprintf(stderr,
+                            "\n Error --  Unknown layout: options are dense:sparse:symmetric:float:integer -L %s\n ",
+                            layout);
+                    ++errorCount;
+                }
                 break;
             case 'm':
-                findMax_ = true;  // go for the maximum value otherwise the minimum is found by default
+                context.find_max = true;  // go for the maximum value otherwise the minimum is found by default
                 break;
             case 'n':
                 param.repeats =
                         strtol(optarg, &chx, 10);  // this sets the number of outer loop repeats without improvement
                 break;
             case 'v':
-                Verbose_ = strtol(optarg, &chx, 10);  // this sets the value of the Verbose
+                context.verbose = strtol(optarg, &chx, 10);  // this sets the value of the Verbose
                 break;
             case 'V':
-                fprintf(outFile_, " Version " VERSION " \n Compiled: " __DATE__
+                fprintf(context.out, " Version " VERSION " \n Compiled: " __DATE__
                                   ","__TIME__
                                   "\n");
                 exit(9);
                 break;
+            case 's':
+                solutionFileName = optarg;
+                if ((solution_input_ = fopen(solutionFileName, "r")) == NULL) {
+                    fprintf(stderr,
+                            "\n\t Error - can't find/open file "
+                            "\"%s\"\n\n",
+                            optarg);
+                    exit(9);
+                }
+                break;
             case 'S':
                 param.sub_size = strtol(optarg, &chx, 10);  // this sets the size of the Partitioning Matrix
                 if (param.sub_size < 10) {
@@ -174,14 +267,15 @@ int main(int argc, char *argv[]) {
                 }
                 break;
             case 'T':
-                Target_ = strtod(optarg, (char **)NULL);  // this sets desired optimal energy
-                TargetSet_ = true;
+                context.target = strtod(optarg, (char **)NULL);  // this sets desired optimal energy
+                context.target_set = true;
                 break;
             case 't':
-                Time_ = strtod(optarg, (char **)NULL);  // this sets the maximum runtime of the algorithm in seconds
+                context.timeout = strtod(optarg, (char **)NULL);  // this sets the maximum runtime of the algorithm in
+                                                                  // seconds
                 break;
             case 'o':
-                if ((outFile_ = fopen(optarg, "w")) == NULL) {
+                if ((context.out = fopen(optarg, "w")) == NULL) {
                     fprintf(stderr,
                             "\n\t Error - can't find/write file "
                             "\"%s\"\n\n",
@@ -195,10 +289,10 @@ int main(int argc, char *argv[]) {
                 exit(0);
                 break;
             case 'r':
-                seed = strtol(optarg, &chx, 10);  // sets the seed value
+                context.seed = strtoull(optarg, &chx, 10);  // sets the seed of the solve's random numbers
                 break;
             case 'w':
-                WriteMatrix_ = true;
+                context.write_matrix = true;
                 break;
             default: /* '?' or unknown */
                 print_help();
@@ -208,75 +302,135 @@ int main(int argc, char *argv[]) {
     }
     // options from command line complete
     //
-    srand(seed);
+    findMax_ = context.find_max;  // read_qubo and the dw interface still take these two from the globals
+    Verbose_ = context.verbose;
 
-    if (inFile == NULL) {
+    if (daemonPath != NULL && (numInFiles > 0 || solution_input_ != NULL || context.write_matrix)) {
+        fprintf(stderr, "\n Error --  -D takes its QUBOs from the socket, -i, -b, -s and -w do not apply\n");
+        exit(9);
+    }
+    if (numInFiles == 0 && daemonPath == NULL) {
         fprintf(stderr,
                 "\n\t%s error -- no input file (-i option) specified"
                 "\n\n",
                 pgmName_);
         exit(9);
     }
+    batch = batch || numInFiles > 1;
+    if (batch && (solution_input_ != NULL || context.write_matrix)) {
+        fprintf(stderr, "\n Error --  -s and -w take a single input file\n");
+        exit(9);
+    }
 
-    errorCount = read_qubo(inFileName, inFile);  // read in the QUBO from file
-
-    if ((errorCount > 0)) {
-        fprintf(stderr,
-                "\n\t%d Input error(s) on file \"%s\"\n\n"
-                "\t%s has been stopped.\n\tThere is a description "
-                "of the .qubo file format: use %s -q to print it\n\n",
-                errorCount, inFileName, pgmName_, pgmName_);
-        exit(1);
+    int nQubos = daemonPath != NULL ? 0 : batch ? numInFiles : 1;
+    qubo_matrix_t *qubos;
+    if (GETMEM(qubos, qubo_matrix_t, MAX(nQubos, 1)) == NULL) BADMALLOC
+    for (int q = 0; q < nQubos; q++) {
+        load_qubo(inFileNames[q], layout, context.write_matrix, &qubos[q]);
     }
 
-    val = (double **)malloc2D(maxNodes_, maxNodes_, sizeof(double));    // create a 2d double array
-    fill_qubo(val, maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);  // move to a 2d array
+    if (solution_input_ != NULL) {  // warm start from the solutions of the -s file
+        param.num_initial_solutions =
+                read_solutions(solutionFileName, solution_input_, maxNodes_, &param.initial_solutions);
+        fclose(solution_input_);
+    }
 
     if (use_dwave) {  // either -S not set and DW_INTERNAL__CONNECTION env variable not NULL, or -S set to 0,
         param.sub_size = dw_init();
         param.sub_sampler = &dw_sub_sample;
+        param.num_threads = 1;  // one connection, the sub QUBOs go to it one at a time
+        param.num_islands = 1;
     }
-    numsolOut_ = 0;
-    print_opts(maxNodes_, &param);
+    if (!batch && daemonPath == NULL) print_opts(&context, maxNodes_, &param);
+
+    context.cancel = &interrupted_;
+#ifdef _WIN32
+    signal(SIGINT, interrupt_handler);
+    signal(SIGTERM, interrupt_handler);
+#else
+    // without SA_RESTART a read the signal arrives in fails with EINTR, so the -D server stops
+    // while it waits for a QUBO too.  A second one ends the program at once, except in the server,
+    // which then still answers the QUBO it is solving and removes its socket.
+    struct sigaction interrupt;
+    memset(&interrupt, 0, sizeof(interrupt));
+    interrupt.sa_handler = interrupt_handler;
+    sigemptyset(&interrupt.sa_mask);
+    interrupt.sa_flags = daemonPath != NULL ? 0 : SA_RESETHAND;
+    sigaction(SIGINT, &interrupt, NULL);
+    sigaction(SIGTERM, &interrupt, NULL);
+#endif
 
     // get some memory for storing and shorting Q bit vectors
     int QLEN = 20;  // the max number of solutions to store in soltuion_lists
-    if (strncmp(&algo_[0], "o", strlen("o")) == 0) {
+    if (strncmp(&context.algo[0], "o", strlen("o")) == 0) {
         QLEN = 20;  // don't need a big que for this optimization
-    } else if (strncmp(&algo_[0], "d", strlen("d")) == 0) {
+    } else if (strncmp(&context.algo[0], "d", strlen("d")) == 0) {
         QLEN = 75;  // this need a lot of diversity
     }
 
-    int8_t **solution_list;
-    double *energy_list;
-    int *solution_counts, *Qindex;
-
-    solution_list = (int8_t **)malloc2D(QLEN + 1, maxNodes_, sizeof(int8_t));
-    if (GETMEM(energy_list, double, QLEN + 1) == NULL) BADMALLOC
-    if (GETMEM(solution_counts, int, QLEN + 1) == NULL) BADMALLOC
-    if (GETMEM(Qindex, int, QLEN + 1) == NULL) BADMALLOC
-
-    solve(val, maxNodes_, solution_list, energy_list, solution_counts, Qindex, QLEN, &param);
+    if (daemonPath != NULL) {
+        // the process, the dw connection and the solution tables stay up from one QUBO to the next
+        run_daemon(&context, &param, layout, QLEN, daemonPath);
+    } else if (batch) {
+        int8_t *solutions;
+        double *energies;
+        int64_t nBits = 0;
+        for (int q = 0; q < nQubos; q++) nBits += qubos[q].size;
+        if (GETMEM(solutions, int8_t, nBits) == NULL) BADMALLOC
+        if (GETMEM(energies, double, nQubos) == NULL) BADMALLOC
+
+        // with a batch -j is the number of QUBOs solved at the same time
+        solve_qubo_batch(&context, qubos, nQubos, QLEN, &param, param.num_threads, solutions, energies);
+
+        double sign = context.find_max ? 1.0 : -1.0;
+        int8_t *solution = solutions;
+        for (int q = 0; q < nQubos; q++) {
+            fprintf(context.out, "%s\n", inFileNames[q]);
+            print_opts(&context, qubos[q].size, &param);
+            for (int i = 0; i < qubos[q].size; i++) fprintf(context.out, "%d", solution[i]);
+            fprintf(context.out, "\n%8.5f Energy of solution\n", energies[q] * sign);
+            solution += qubos[q].size;
+        }
+        free(solutions);
+        free(energies);
+    } else {
+        int8_t **solution_list;
+        double *energy_list;
+        int *solution_counts, *Qindex;
+
+        solution_list = (int8_t **)malloc2D(QLEN + 1, maxNodes_, sizeof(int8_t));
+        if (GETMEM(energy_list, double, QLEN + 1) == NULL) BADMALLOC
+        if (GETMEM(solution_counts, int, QLEN + 1) == NULL) BADMALLOC
+        if (GETMEM(Qindex, int, QLEN + 1) == NULL) BADMALLOC
+
+        solve_qubo_context(&context, &qubos[0], solution_list, energy_list, solution_counts, Qindex, QLEN, &param);
+
+        free(solution_list);
+        free(energy_list);
+        free(solution_counts);
+        free(Qindex);
+    }
 
-    free(solution_list);
-    free(energy_list);
-    free(solution_counts);
-    free(Qindex);
-    free(val);
+    free(param.initial_solutions);
+    for (int q = 0; q < nQubos; q++) free_qubo(&qubos[q]);
+    free(qubos);
 
     if (use_dwave) {
         dw_close();
     }
-    if (Verbose_ > 3) {
-        fprintf(outFile_, "\n\t\"qbsolv  -i %s\" (%d nodes, %d couplers) - end-of-job\n\n", inFileName, nNodes_,
-                nCouplers_);
+    if (context.verbose > 3 && !batch && daemonPath == NULL) {
+        fprintf(context.out, "\n\t\"qbsolv  -i %s\" (%d nodes, %d couplers) - end-of-job\n\n", inFileNames[0],
+                nNodes_, nCouplers_);
     }
+    for (int q = 0; q < numInFiles; q++) free(inFileNames[q]);
+    free(inFileNames);
     exit(0);
 }
 
 void print_help(void) {
-    printf("\n\t%s -i infile [-o outfile] [-m] [-T] [-n] [-S SubMatrix] [-w] \n"
+    printf("\n\t%s -i infile [-o outfile] [-m] [-T] [-n] [-S SubMatrix] [-w] [-L layout] \n"
            "\t\t[-h] [-a algorithm] [-v verbosityLevel] [-V] [-q] [-t seconds]\n"
+           "\t\t[-j threads] [-g] [-I islands] [-s solutionIn] [-b manifest] [-D socket]\n"
            "\nDESCRIPTION\n"
            "\tqbsolv executes a quadratic unconstrained binary optimization \n"
            "\t(QUBO) problem represented in a file, providing bit-vector \n"
@@ -288,7 +442,31 @@ void print_help(void) {
            "\t\tThe options are as follows: \n"
            "\t-i infile \n"
            "\t\tThe name of the file in which the input QUBO resides.  This \n"
-           "\t\tis a required option. \n"
+           "\t\tis a required option, unless -b is given.  Given more than \n"
+           "\t\tonce, the QUBOs are solved as a batch, see -b. \n"
+           "\t-b manifest \n"
+           "\t\tThis optional argument is a file naming one QUBO file a line,\n"
+           "\t\tblank lines and lines starting with # are skipped.  The QUBOs\n"
+           "\t\tare solved independently, -j of them at the same time, each\n"
+           "\t\twith a seed of its own drawn from -r, and for each the file\n"
+           "\t\tname, the options line, the best solution and its energy are\n"
+           "\t\tprinted in the order given.  -s and -w take a single input\n"
+           "\t\tfile. \n"
+           "\t-D socket \n"
+           "\t\tThis optional argument runs qbsolv as a server: QUBOs in the\n"
+           "\t\tQUBO(5) format are read one after the other from connections\n"
+           "\t\tto the Unix domain socket of that name, or from the standard\n"
+           "\t\tinput when it is -, and for each the best solution and its\n"
+           "\t\tenergy are written back as two lines, or a line starting with\n"
+           "\t\t\"error:\" for a bad QUBO.  A QUBO ends after the entries its\n"
+           "\t\tp line announces.  Every QUBO is solved with the other options,\n"
+           "\t\twith a seed of its own drawn from -r.  An interrupt cuts the\n"
+           "\t\tQUBO being solved short, answers it and stops the server, or\n"
+           "\t\tstops it at once while it waits for a QUBO.  A connection\n"
+           "\t\tthat sends or reads nothing for 30 seconds is closed.  A QUBO\n"
+           "\t\tof more than 20000 variables or 10000000 entries is answered\n"
+           "\t\twith an error line.\n"
+           "\t\t-i, -b, -s and -w do not apply. \n"
            "\t-o outfile \n"
            "\t\tThis optional argument denotes the name of the file to \n"
            "\t\twhich the output will be written.  The default is the \n"
@@ -306,9 +484,12 @@ void print_help(void) {
            "\t\ttarget value of the objective function is found. \n"
            "\t-t timeout \n"
            "\t\tThis optional argument stops execution when the elapsed \n"
-           "\t\tcpu time equals or exceeds timeout value. Timeout is only checked \n"
-           "\t\tafter completion of the main loop. Other halt values \n"
+           "\t\twall clock time equals or exceeds timeout value, returning \n"
+           "\t\tthe best solution found so far.  The searches look at the \n"
+           "\t\tclock every few thousand bit flips. Other halt values \n"
            "\t\tsuch as \'target\' and \'repeats\' will halt before \'timeout\'.\n"
+           "\t\tAn interrupt (SIGINT or SIGTERM) stops execution the same way,\n"
+           "\t\ta second one ends the program at once, except with -D.\n"
            "\t\tThe default value is %8.1f.\n"
            "\t-n repeats \n"
            "\t\tThis optional argument denotes, once a new optimal value is \n"
@@ -328,7 +509,41 @@ void print_help(void) {
            "\t\tIf present, this optional argument is a filename that is\n"
            "\t\tin the format of the first 2 records of the output solution file,\n"
            "\t\tthe solution read from this file will be the initial solution used\n"
-           "\t\tin the solver\n"
+           "\t\tin the solver.  Every line of 0s and 1s as long as the QUBO is\n"
+           "\t\ta solution, so the output of an earlier run can be given, and\n"
+           "\t\tthe solver starts from the best of them.\n"
+           "\t-L layout \n"
+           "\t\tThis optional argument chooses how the QUBO is stored. \n"
+           "\t\t \'dense\' packed upper triangular matrix.\n"
+           "\t\t \'sparse\' adjacency lists, memory and time per bit flip scale\n"
+           "\t\t with the number of couplers.\n"
+           "\t\t \'symmetric\' full mirrored matrix, four times the memory of\n"
+           "\t\t dense but every bit flip reads one contiguous row.\n"
+           "\t\t 'float' dense plus a symmetric single precision copy that\n"
+           "\t\t the bit flips read, full evaluations stay in double.\n"
+           "\t\t 'integer' dense plus a symmetric 32 bit integer copy, for\n"
+           "\t\t QUBOs with integer coefficients only, energies are exact.\n"
+           "\t\tThe default is sparse when fewer than 5%% of the possible couplers\n"
+           "\t\tare present and dense otherwise.\n"
+           "\t-j threads \n"
+           "\t\tThis optional argument is the number of subproblems solved\n"
+           "\t\tat the same time, each on its own thread.  Every batch of\n"
+           "\t\tsubproblems starts from the same solution and their results\n"
+           "\t\tare merged in order, so a run is repeatable for a given number\n"
+           "\t\tof threads.  With a batch of QUBOs (-b) it is the number of\n"
+           "\t\tQUBOs solved at the same time instead.  The default value is 1. \n"
+           "\t-g \n"
+           "\t\tIf present with -j, the subproblems solved at the same time\n"
+           "\t\tshare no couplers, so each sees exactly the values it would\n"
+           "\t\tsee if it were solved alone. \n"
+           "\t-I islands \n"
+           "\t\tThis optional argument is the number of copies of the main\n"
+           "\t\tloop run at the same time, each on its own thread with its\n"
+           "\t\town solution.  Every few passes each copy shares its best\n"
+           "\t\tsolution with the others, and instead of restarting from a\n"
+           "\t\trandom solution it restarts from the shared ones.  Runs with\n"
+           "\t\tmore than one island are not repeatable.  The default value\n"
+           "\t\tis 1. \n"
            "\t-w \n"
            "\t\tIf present, this optional argument will print the QUBO \n"
            "\t\tmatrix and result in .csv format. \n"
@@ -352,7 +567,7 @@ void print_help(void) {
            "\t\tformat of the QUBO file.\n"
            "\t-r seed \n"
            "\t\tUsed to reset the seed for the random number generation \n",
-           pgmName_, Time_, defaultRepeats);
+           pgmName_, default_context().timeout, defaultRepeats);
 
     return;
 }
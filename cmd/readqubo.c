@@ -19,17 +19,20 @@
 #include "extern.h"
 #include "macros.h"
 #include "readqubo.h"
+#include "util.h"
 
 // read from inFile and parse the qubo file
 
-int pFound = false;
-int lineNm = 0;
-const char s[2] = " ";  // TODO: please comment what this variable is for
-int i, j, k;            // standard scratch ints
-int inode = 0, icoupler = 0;
-double f;
+static int pFound = false;
+static int lineNm = 0;
+static const double sparseDensity = 0.05;  // fraction of possible couplers below which the sparse layout is used
+static int i, j;  // standard scratch ints
+static int inode = 0, icoupler = 0;
+static double f;
 
 int read_qubo(const char *inFileName, FILE *inFile) {
+    pFound = false;  // a batch reads one file after another
+    lineNm = inode = icoupler = 0;
     int lineLen;
     size_t linecap = 0;
     char *line = NULL;
@@ -103,7 +106,7 @@ int read_qubo(const char *inFileName, FILE *inFile) {
                     couplers_[icoupler].n2 = j;
                     couplers_[icoupler++].value = f;
                 }
-                if ((i + 1 > maxNodes_) || (j + 1 > maxNodes_)) {
+                if ((i < 0) || (i + 1 > maxNodes_) || (j + 1 > maxNodes_)) {
                     fprintf(stderr, " Coordinates out of bounds ( 0 to %d )  at line %d %s,\n %d %d\n", maxNodes_,
                             lineNm, line, i, j);
                     exit(9);
@@ -111,6 +114,7 @@ int read_qubo(const char *inFileName, FILE *inFile) {
             }
         }
     }
+    free(line);
 
     int errors = 0;
     if (icoupler != nCouplers_) {
@@ -128,32 +132,329 @@ int read_qubo(const char *inFileName, FILE *inFile) {
     return errors;
 }
 
-//  zero out and fill 2d arrary val from nodes and couplers (negate if looking for minimum)
+// the p line that cut a QUBO of a stream short, the first line of the next one
+static char *heldLine = NULL;
+
+// the next line of a stream of QUBOs, as getline
+static int next_job_line(char **line, size_t *linecap, FILE *inFile) {
+    if (heldLine != NULL) {
+        free(*line);
+        *line = heldLine;
+        *linecap = strlen(heldLine) + 1;
+        heldLine = NULL;
+        return (int)strlen(*line);
+    }
+#if _WIN32
+    return getline_win(line, linecap, inFile);
+#else
+    return getline(line, linecap, inFile);
+#endif
+}
+
+//  read the next QUBO of a stream of them into the globals, for the daemon.  The format is the one
+//  of read_qubo, but a QUBO ends after the nNodes + nCouplers entries its p line announces, and a
+//  bad one is reported in message rather than ending the program; the lines up to the next p line
+//  are then skipped.  A QUBO larger than the limits is a bad one, so a client cannot make the
+//  daemon ask for more memory than they allow.
+//
+//  @param inFile the stream
+//  @param max_nodes the most variables a QUBO may have
+//  @param max_entries the most entries, nNodes + nCouplers, a QUBO may have
+//  @param[out] message what is wrong with a bad QUBO
+//  @param message_len the room in message
+//  @return 1 when a QUBO was read, 0 at the end of the stream, -1 for a bad QUBO
+int read_qubo_job(FILE *inFile, int max_nodes, int max_entries, char *message, int message_len) {
+    int lineLen, result = 1, n1, n2;
+    size_t linecap = 0;
+    char *line = NULL;
+    char token[50], tokenp[50], topology[MAX_TOPOLOGY_LEN + 1];
+    double value;
+
+    nodes_ = couplers_ = NULL;
+    pFound = false;
+    inode = icoupler = 0;
+    while ((lineLen = next_job_line(&line, &linecap, inFile)) > 0) {
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r')) line[--lineLen] = '\0';
+        if (line[0] == 'c' || line[0] == 'C') continue;  // comment line
+        if (!pFound) {
+            if (line[0] != 'p' && line[0] != 'P') continue;  // not the start of a QUBO, skip it
+            if (sscanf(line, " %49s %49s %49s %d %d %d", tokenp, token, topology, &maxNodes_, &nNodes_,
+                       &nCouplers_) != 6 ||
+                strncmp(token, "qubo", 4) != 0 ||
+                (strncmp(topology, "0", 1) != 0 && strncmp(topology, "unconstrained", 13) != 0) || maxNodes_ < 1 ||
+                nNodes_ < 0 || nCouplers_ < 0) {
+                snprintf(message, message_len, "bad p line \"%s\"", line);
+                result = -1;
+                break;
+            }
+            if (maxNodes_ > max_nodes || (int64_t)nNodes_ + nCouplers_ > max_entries) {
+                snprintf(message, message_len,
+                         "QUBO of %d variables and %d + %d entries, more than the %d variables and %d entries taken",
+                         maxNodes_, nNodes_, nCouplers_, max_nodes, max_entries);
+                result = -1;
+                break;
+            }
+            GETMEM(nodes_, struct nodeStr_, MAX(nNodes_, 1));
+            GETMEM(couplers_, struct nodeStr_, MAX(nCouplers_, 1));
+            if (nodes_ == NULL || couplers_ == NULL) {
+                snprintf(message, message_len, "out of memory for a QUBO of %d entries", nNodes_ + nCouplers_);
+                result = -1;
+                break;
+            }
+            pFound = true;
+        } else if (line[0] == 'p' || line[0] == 'P') {
+            snprintf(message, message_len, "QUBO ended after %d of its %d entries", inode + icoupler,
+                     nNodes_ + nCouplers_);
+            heldLine = line;  // the start of the next QUBO
+            line = NULL;
+            result = -1;
+            break;
+        } else if (sscanf(line, "%d %d %lf", &n1, &n2, &value) == 3) {
+            if (n1 < 0 || n1 > n2 || n2 >= maxNodes_ || (n1 == n2 ? inode == nNodes_ : icoupler == nCouplers_)) {
+                snprintf(message, message_len, "entry \"%s\" is out of range or one too many", line);
+                result = -1;
+                break;
+            }
+            struct nodeStr_ *entry = n1 == n2 ? &nodes_[inode++] : &couplers_[icoupler++];
+            entry->n1 = n1;
+            entry->n2 = n2;
+            entry->value = value;
+        }
+        if (pFound && inode + icoupler == nNodes_ + nCouplers_) break;  // the QUBO is complete
+    }
+    free(line);
+
+    if (result == 1 && !pFound) return 0;
+    if (result == 1 && inode + icoupler < nNodes_ + nCouplers_) {
+        snprintf(message, message_len, "input ended after %d of the %d entries of a QUBO", inode + icoupler,
+                 nNodes_ + nCouplers_);
+        result = -1;
+    }
+    if (result == -1) {
+        free(nodes_);
+        free(couplers_);
+    }
+    return result;
+}
+
+//  zero out and fill upper triangular 2d arrary val from nodes and couplers (negate if looking for minimum)
 //
 void fill_qubo(double **qubo, int maxNodes, struct nodeStr_ *nodes, int nNodes, struct nodeStr_ *couplers,
                int nCouplers) {
-    // Zero out the qubo
+    // Zero out the upper triangle of the qubo, the only part that is stored
     for (int i = 0; i < maxNodes; i++) {
-        for (int j = 0; j < maxNodes; j++) {
+        for (int j = i; j < maxNodes; j++) {
             qubo[i][j] = 0.0;
         }
     }
 
     // Copy the structs into the matrix, flip the sign if we are looking for the
-    // minimum value during the optimization.
+    // minimum value during the optimization.  Repeated entries are summed, as
+    // sparse_qubo_create does, so the layout does not change the QUBO.
     if (findMax_) {
         for (int i = 0; i < nNodes; i++) {
-            qubo[nodes[i].n1][nodes[i].n1] = nodes[i].value;
+            qubo[nodes[i].n1][nodes[i].n1] += nodes[i].value;
         }
         for (int i = 0; i < nCouplers; i++) {
-            qubo[couplers[i].n1][couplers[i].n2] = couplers[i].value;
+            qubo[couplers[i].n1][couplers[i].n2] += couplers[i].value;
         }
     } else {
         for (int i = 0; i < nNodes; i++) {
-            qubo[nodes[i].n1][nodes[i].n1] = -nodes[i].value;
+            qubo[nodes[i].n1][nodes[i].n1] -= nodes[i].value;
         }
         for (int i = 0; i < nCouplers; i++) {
-            qubo[couplers[i].n1][couplers[i].n2] = -couplers[i].value;
+            qubo[couplers[i].n1][couplers[i].n2] -= couplers[i].value;
+        }
+    }
+}
+
+//  build a sparse qubo from nodes and couplers (negate if looking for minimum)
+//
+sparse_qubo_t *fill_sparse_qubo(int maxNodes, struct nodeStr_ *nodes, int nNodes, struct nodeStr_ *couplers,
+                                int nCouplers) {
+    int32_t *rows, *cols;
+    double *values;
+    int nEntries = nNodes + nCouplers;
+    double sign = findMax_ ? 1.0 : -1.0;
+
+    if (GETMEM(rows, int32_t, MAX(nEntries, 1)) == NULL) BADMALLOC
+    if (GETMEM(cols, int32_t, MAX(nEntries, 1)) == NULL) BADMALLOC
+    if (GETMEM(values, double, MAX(nEntries, 1)) == NULL) BADMALLOC
+
+    for (int i = 0; i < nNodes; i++) {
+        rows[i] = nodes[i].n1;
+        cols[i] = nodes[i].n1;
+        values[i] = sign * nodes[i].value;
+    }
+    for (int i = 0; i < nCouplers; i++) {
+        rows[nNodes + i] = couplers[i].n1;
+        cols[nNodes + i] = couplers[i].n2;
+        values[nNodes + i] = sign * couplers[i].value;
+    }
+
+    sparse_qubo_t *qubo = sparse_qubo_create(maxNodes, nEntries, rows, cols, values);
+    if (qubo == NULL) {  // the readers check every entry
+        fprintf(stderr, " An entry of the QUBO is out of range\n");
+        exit(9);
+    }
+
+    free(rows);
+    free(cols);
+    free(values);
+    return qubo;
+}
+
+//  build qubo from the nodes and couplers read last, releasing them, in the given layout, or when
+//  layout is NULL the one its density calls for.  Sparse problems are kept in adjacency form, so
+//  memory and the cost of a bit flip scale with the number of couplers, the -w print out of the
+//  matrix needs a dense form.
+//
+//  @param layout dense, sparse, symmetric, float, integer or NULL
+//  @param write_matrix true if the matrix is to be printed, which the sparse layout cannot
+//  @param[out] qubo the QUBO, to be released with free_qubo
+//  @return 0, or -1 with nothing built when the integer layout cannot hold the coefficients
+int build_qubo(const char *layout, bool write_matrix, qubo_matrix_t *qubo) {
+    if (layout == NULL) {
+        layout = "dense";
+        if (!write_matrix && (double)nCouplers_ < sparseDensity * (double)maxNodes_ * (double)maxNodes_ / 2.0) {
+            layout = "sparse";
+        }
+    }
+    if (write_matrix && strcmp(layout, "sparse") == 0) layout = "dense";
+
+    double **val = NULL;
+    qubo->size = maxNodes_;
+    qubo->dense = NULL;
+    qubo->single = NULL;
+    qubo->integer = NULL;
+    qubo->sparse = NULL;
+    if (strcmp(layout, "sparse") == 0) {
+        qubo->layout = QUBO_SPARSE;
+        qubo->sparse = fill_sparse_qubo(maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);
+    } else if (strcmp(layout, "symmetric") == 0) {
+        val = (double **)malloc2D_aligned(maxNodes_, maxNodes_, sizeof(double));  // create a 2d double array
+        fill_qubo(val, maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);       // move to a 2d array
+        symmetrize_qubo(val, maxNodes_);  // mirror it into the lower triangle
+        qubo->layout = QUBO_SYMMETRIC;
+        qubo->dense = val;
+    } else if (strcmp(layout, "float") == 0) {
+        val = (double **)malloc2D_triangular(maxNodes_, sizeof(double));   // create a packed 2d double array
+        fill_qubo(val, maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);  // move to a 2d array
+        qubo->layout = QUBO_FLOAT;
+        qubo->dense = val;
+        qubo->single = float_qubo_create(val, maxNodes_);  // mirrored float copy for the bit flip updates
+    } else if (strcmp(layout, "integer") == 0) {
+        val = (double **)malloc2D_triangular(maxNodes_, sizeof(double));   // create a packed 2d double array
+        fill_qubo(val, maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);  // move to a 2d array
+        if (!qubo_is_integral(val, maxNodes_)) {
+            free(val);
+            free(nodes_);
+            free(couplers_);
+            return -1;
+        }
+        qubo->layout = QUBO_INTEGER;
+        qubo->dense = val;
+        qubo->integer = integer_qubo_create(val, maxNodes_);  // mirrored integer copy used by the kernels
+    } else {
+        val = (double **)malloc2D_triangular(maxNodes_, sizeof(double));   // create a packed 2d double array
+        fill_qubo(val, maxNodes_, nodes_, nNodes_, couplers_, nCouplers_);  // move to a 2d array
+        qubo->layout = QUBO_DENSE;
+        qubo->dense = val;
+    }
+    free(nodes_);  // the next QUBO read allocates its own
+    free(couplers_);
+    return 0;
+}
+
+//  release the matrices of a QUBO from build_qubo
+void free_qubo(qubo_matrix_t *qubo) {
+    free(qubo->dense);
+    sparse_qubo_free(qubo->sparse);
+    free(qubo->single);
+    free(qubo->integer);
+}
+
+//  read the solutions of a -s file: every line of nbits 0 and 1 characters is a solution and any
+//  other line is skipped, so the output of a run of qbsolv on the same QUBO can be read back in
+//
+//  @param inFileName the name of the file, for the error messages
+//  @param inFile the file
+//  @param nbits the number of variables of the QUBO
+//  @param[out] solutions the solutions read, a malloc2D array of nbits columns
+//  @return the number of solutions
+int read_solutions(const char *inFileName, FILE *inFile, int nbits, int8_t ***solutions) {
+    int lineLen, lineNum = 0, count = 0, room = 4;
+    size_t linecap = 0;
+    char *line = NULL;
+    int8_t *bits;
+
+    if (GETMEM(bits, int8_t, (size_t)room * nbits) == NULL) BADMALLOC
+#if _WIN32
+    while ((lineLen = getline_win(&line, &linecap, inFile)) > 0) {
+#else
+    while ((lineLen = getline(&line, &linecap, inFile)) > 0) {
+#endif
+        lineNum++;
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r' || line[lineLen - 1] == ' ')) {
+            line[--lineLen] = '\0';
+        }
+        if (lineLen == 0 || (int)strspn(line, "01") != lineLen) continue;  // not a solution line
+        if (lineLen != nbits) {
+            fprintf(stderr, " Solution at line %d of %s has %d bits, the QUBO has %d\n", lineNum, inFileName, lineLen,
+                    nbits);
+            exit(9);
+        }
+        if (count == room) {
+            room *= 2;
+            if ((bits = (int8_t *)realloc(bits, (size_t)room * nbits)) == NULL) BADMALLOC
         }
+        for (int k = 0; k < nbits; k++) bits[(size_t)count * nbits + k] = line[k] - '0';
+        count++;
+    }
+    free(line);
+
+    if (count == 0) {
+        fprintf(stderr, " No solution of %d bits in %s\n", nbits, inFileName);
+        exit(9);
+    }
+    *solutions = (int8_t **)malloc2D(count, nbits, sizeof(int8_t));
+    for (int s = 0; s < count; s++) {
+        for (int k = 0; k < nbits; k++) (*solutions)[s][k] = bits[(size_t)s * nbits + k];
+    }
+    free(bits);
+    return count;
+}
+
+//  read the QUBO file names of a -b manifest, one a line, skipping blank lines and lines starting
+//  with #, appending them to the *count names in *names
+//
+//  @param inFileName the name of the manifest, for the error messages
+//  @param inFile the manifest
+//  @param[in,out] names the file names, a malloc'ed array of malloc'ed strings
+//  @param[in,out] count the number of file names
+void read_manifest(const char *inFileName, FILE *inFile, char ***names, int *count) {
+    int lineLen, found = 0;
+    size_t linecap = 0;
+    char *line = NULL;
+
+#if _WIN32
+    while ((lineLen = getline_win(&line, &linecap, inFile)) > 0) {
+#else
+    while ((lineLen = getline(&line, &linecap, inFile)) > 0) {
+#endif
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r' || line[lineLen - 1] == ' ')) {
+            line[--lineLen] = '\0';
+        }
+        if (lineLen == 0 || line[0] == '#') continue;
+        if ((*names = (char **)realloc(*names, (*count + 1) * sizeof(char *))) == NULL) BADMALLOC
+        if (GETMEM((*names)[*count], char, lineLen + 1) == NULL) BADMALLOC
+        strcpy((*names)[(*count)++], line);
+        found++;
+    }
+    free(line);
+
+    if (found == 0) {
+        fprintf(stderr, " No QUBO file named in %s\n", inFileName);
+        exit(9);
     }
 }
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <stdio.h>
+#include "qbsolv.h"
 #include "stdheaders_shim.h"
 
 #ifdef __cplusplus
@@ -27,12 +28,34 @@ struct nodeStr_ {
     double value;
 };
 
-//  zero out and fill 2d arrary val from nodes and couplers (negate if looking for minimum)
+//  zero out and fill upper triangular 2d arrary val from nodes and couplers (negate if looking for minimum)
 void fill_qubo(double **qubo, int maxNodes, struct nodeStr_ *nodes, int nNodes, struct nodeStr_ *couplers,
                int nCouplers);
 
+//  build a sparse qubo from nodes and couplers (negate if looking for minimum)
+sparse_qubo_t *fill_sparse_qubo(int maxNodes, struct nodeStr_ *nodes, int nNodes, struct nodeStr_ *couplers,
+                                int nCouplers);
+
 int read_qubo(const char *inFileName, FILE *inFile);
 
+//  read the next QUBO of a stream of them into the globals, as read_qubo but reporting a bad one, or
+//  one of more than max_nodes variables or max_entries entries, in message; returns 1 for a QUBO, 0
+//  at the end of the stream and -1 for a bad QUBO
+int read_qubo_job(FILE *inFile, int max_nodes, int max_entries, char *message, int message_len);
+
+//  build qubo from the nodes and couplers read last in layout, NULL for the one its density calls
+//  for; returns 0, or -1 when the integer layout cannot hold the coefficients
+int build_qubo(const char *layout, bool write_matrix, qubo_matrix_t *qubo);
+
+//  release the matrices of a QUBO from build_qubo
+void free_qubo(qubo_matrix_t *qubo);
+
+//  read the solutions of nbits variables in inFile into *solutions, a malloc2D array, returning how many
+int read_solutions(const char *inFileName, FILE *inFile, int nbits, int8_t ***solutions);
+
+//  append the QUBO file names of the manifest inFile, one a line, to the *count names in *names
+void read_manifest(const char *inFileName, FILE *inFile, char ***names, int *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,6 +14,9 @@
 
 #include "stdheaders_shim.h"
 
+#include <signal.h>
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -25,6 +28,17 @@ extern "C" {
 // - a state vector: on input is the current best state, and should be set to the output state
 typedef void (*SubSolver)(double**, int, int8_t*, void*);
 
+// The pointer type for the progress callback, called each time the solve finds a better solution.
+// Its arguments are:
+// - the solution, valid only during the call
+// - the number of variables
+// - the energy of the solution, as printed
+// - the wall clock seconds since the solve started
+// - the candidate bit flips and the sub QUBOs solved so far
+// - the progress_data of the parameters
+// It returns false to stop the solve, which then returns the best solution it has.
+typedef bool (*ProgressCallback)(const int8_t*, int, double, double, int64_t, long, void*);
+
 // A parameter structure used to pass in optional arguments to the qbsolv: solve method.
 typedef struct parameters_t {
     // The number of iterations without improvement before giving up
@@ -35,21 +49,217 @@ typedef struct parameters_t {
     int32_t sub_size;
     // Extra parameter data passed to sub_sampler for callback specific data.
     void* sub_sampler_data;
+    // The number of sub-qubos of a submatrix pass solved at the same time, each on its own thread.
+    // With 1 they are solved one after the other, each starting from the solution the previous
+    // ones left; with more, each batch starts from the same solution and the results are merged
+    // in pass order, so a run depends on num_threads but not on how the threads are scheduled.
+    // sub_sampler must be safe to call from several threads at once when this is above 1.
+    int32_t num_threads;
+    // When true, and num_threads is above 1, the sub-qubos of a batch never share a coupler, so
+    // each is clamped by exactly the values it would see if it were solved alone
+    bool independent_groups;
+    // The number of islands: outer loops run side by side, each on its own thread with its own
+    // solution, tabu state and random numbers, over the one read-only QUBO.  The islands share
+    // their best solutions through the solution tables passed to solve, and restart from them
+    // rather than from random solutions.  Which island finds what first depends on how the threads
+    // are scheduled, so runs with more than 1 island are not repeatable.
+    // sub_sampler must be safe to call from several threads at once when this is above 1.
+    int32_t num_islands;
+    // The outer loop passes of an island between sharing its best solution with the others
+    int32_t migration_interval;
+    // Called with every better solution, or NULL.  With islands it is called for the solutions
+    // they share, one call at a time.
+    ProgressCallback progress;
+    // Extra parameter data passed to progress
+    void* progress_data;
+    // Solutions of 0 and 1 values to warm start from: they go into the solution tables before the
+    // initial search, which starts from the best of them.  NULL for a random start.
+    int8_t** initial_solutions;
+    int32_t num_initial_solutions;
 } parameters_t;
 
+// The run options and output state of one solve, what `solve_qubo_context` reads in place of the
+// globals of extern.h. Solves with contexts of their own may run at the same time on different
+// threads, provided their sub_samplers may be called that way.
+typedef struct qbsolv_context_t {
+    // How much to print: 0 the result only, up to 4 for every tabu improvement
+    int32_t verbose;
+    // Print nothing at all whatever verbose and write_matrix, for callers that read the results
+    // from the solution tables
+    bool quiet;
+    // Search for the maximum of the QUBO rather than its minimum, only the sign of what is printed
+    bool find_max;
+    // The outer loop, "o" for energy impact or "d" for solution diversity
+    char algo[4];
+    // Stop once an energy of target is reached, when target_set is true
+    bool target_set;
+    double target;
+    // The wall clock seconds after which the solve stops and returns the best solution it has
+    double timeout;
+    // The tabu tenure of the full QUBO searches, -1 to pick it from the size of the QUBO
+    int32_t tabu_tenure;
+    // Print the QUBO around the best solution at the end, for dense layouts
+    bool write_matrix;
+    // Where the results are printed
+    FILE* out;
+    // The number of results printed so far, counted up by the solve
+    int32_t num_outputs;
+    // The seed of the random number generator of the solve, the same seed gives the same run
+    uint64_t seed;
+    // solver_wall_seconds() at the start of the solve, what the seconds printed count from
+    double start;
+    // solver_wall_seconds() when the searches stop, set from timeout at the start of the solve
+    double deadline;
+    // When not NULL, the solve stops soon after *cancel becomes nonzero and returns the best
+    // solution it has.  It may be set from any thread, or from a signal handler.
+    volatile sig_atomic_t* cancel;
+} qbsolv_context_t;
+
+// A QUBO stored as a compressed sparse row adjacency structure.
+// Every coupler (i, j) is listed in the rows of both i and j, with the columns of
+// each row in increasing order, so the whole neighbourhood of a variable is
+// contiguous.  The linear terms are kept apart in `diagonal`.
+typedef struct sparse_qubo_t {
+    // The number of variables
+    int32_t size;
+    // Offsets of the rows into columns/values, size + 1 entries
+    int64_t* row_start;
+    // The neighbouring variable of each entry
+    int32_t* columns;
+    // The coupler strength of each entry
+    double* values;
+    // The linear term of each variable
+    double* diagonal;
+} sparse_qubo_t;
+
+// The storage layouts understood by the solver kernels
+typedef enum qubo_layout_t {
+    // upper triangular size x size matrix addressed as dense[i][j], i <= j,
+    // the lower triangle is never read so it may be packed (malloc2D_triangular)
+    QUBO_DENSE = 0,
+    // compressed sparse row adjacency, see sparse_qubo_t
+    QUBO_SPARSE = 1,
+    // full size x size matrix held in dense with dense[i][j] == dense[j][i] (symmetrize_qubo),
+    // so every variable's couplers are one contiguous row
+    QUBO_SYMMETRIC = 2,
+    // upper triangular double matrix in dense as for QUBO_DENSE, plus a mirrored single precision
+    // copy in single (float_qubo_create) that the bit flip updates read; full evaluations use dense
+    QUBO_FLOAT = 3,
+    // upper triangular double matrix in dense as for QUBO_DENSE, plus a mirrored int32_t copy in
+    // integer (integer_qubo_create) for QUBOs whose coefficients are all integers, the kernels
+    // read only the integer copy and compute exact energies
+    QUBO_INTEGER = 4
+} qubo_layout_t;
+
+// A QUBO in one of the supported storage layouts, the input to `solve_qubo`
+typedef struct qubo_matrix_t {
+    qubo_layout_t layout;
+    // The number of variables
+    int32_t size;
+    // The matrix when layout is QUBO_DENSE, QUBO_SYMMETRIC, QUBO_FLOAT or QUBO_INTEGER
+    double** dense;
+    // The single precision copy when layout is QUBO_FLOAT
+    float** single;
+    // The integer copy when layout is QUBO_INTEGER
+    int32_t** integer;
+    // The matrix when layout is QUBO_SPARSE, the solves only read it, qubo_apply_changes sets entries
+    sparse_qubo_t* sparse;
+} qubo_matrix_t;
+
+// An entry of a QUBO set to a new value: row <= col, row == col for a linear term.  The value is
+// in the convention of the matrix it changes (the command line program negates the file when
+// minimizing).
+typedef struct qubo_change_t {
+    int32_t row;
+    int32_t col;
+    double value;
+} qubo_change_t;
+
+// What a solve leaves behind to re-solve the same QUBO after a few of its entries change, from
+// qbsolv_state_create.  The solution tables are the ones solve_qubo fills.
+typedef struct qbsolv_state_t {
+    // The number of variables
+    int32_t size;
+    // The solution tables: QLEN + 1 rows of solutions, their energies, counts and order
+    int32_t QLEN;
+    int8_t** solution_list;
+    double* energy_list;
+    int* solution_counts;
+    int* Qindex;
+    // The best solution at the end of the last solve, its flip costs and energy, which the next
+    // solve resumes from
+    int8_t* solution;
+    double* flip_cost;
+    double energy;
+    // True once the tables and solution hold the result of a solve
+    bool valid;
+} qbsolv_state_t;
+
+// Build a sparse QUBO from num_entries upper triangular (row, column, value) entries,
+// entries with row == column are linear terms, repeated entries are summed
+sparse_qubo_t* sparse_qubo_create(int32_t size, int64_t num_entries, const int32_t* rows, const int32_t* cols,
+                                  const double* values);
+
+// Release a QUBO created by sparse_qubo_create
+void sparse_qubo_free(sparse_qubo_t* qubo);
+
 // Get the default values for the optional parameters structure
 parameters_t default_parameters(void);
 
+// Get a context with the defaults of the command line program, printing to stdout
+qbsolv_context_t default_context(void);
+
 // Callback for `solve` to use one of the `dw` calling methods
 void dw_sub_sample(double** sub_qubo, int subMatrix, int8_t* sub_solution, void*);
 
 // Callback for `solve` to use tabu on subproblems
 void tabu_sub_sample(double** sub_qubo, int subMatrix, int8_t* sub_solution, void*);
 
-// Entry into the overall solver from the main program
+// Entry into the overall solver from the main program, with the options and output state of the
+// globals in extern.h
 void solve(double** qubo, const int qubo_size, int8_t** solution_list, double* energy_list, int* solution_counts,
            int* Qindex, int QLEN, parameters_t* param);
 
+// Entry into the overall solver for a QUBO in any of the supported layouts, with the options and
+// output state of the globals in extern.h
+void solve_qubo(const qubo_matrix_t* qubo, int8_t** solution_list, double* energy_list, int* solution_counts,
+                int* Qindex, int QLEN, parameters_t* param);
+
+// `solve` with the options and output state of ctx rather than the globals
+void solve_context(qbsolv_context_t* ctx, double** qubo, const int qubo_size, int8_t** solution_list,
+                   double* energy_list, int* solution_counts, int* Qindex, int QLEN, parameters_t* param);
+
+// `solve_qubo` with the options and output state of ctx rather than the globals
+void solve_qubo_context(qbsolv_context_t* ctx, const qubo_matrix_t* qubo, int8_t** solution_list, double* energy_list,
+                        int* solution_counts, int* Qindex, int QLEN, parameters_t* param);
+
+// Get an empty state for a QUBO of size variables with solution tables of QLEN entries
+qbsolv_state_t* qbsolv_state_create(int32_t size, int32_t QLEN);
+
+// Release a state from qbsolv_state_create
+void qbsolv_state_free(qbsolv_state_t* state);
+
+// Set entries of qubo to new values, bringing the energies of the solutions of state and the flip
+// costs of its solution up to date in O(1) a change, state may be NULL.  Returns 0, or -1 with
+// nothing changed when an entry is out of range, is a coupler the sparse layout does not have, or
+// is not an integer for the integer layout, the QUBO must then be rebuilt; or when state is for a
+// QUBO of another size.
+int qubo_apply_changes(qubo_matrix_t* qubo, qbsolv_state_t* state, const qubo_change_t* changes, int num_changes);
+
+// `solve_qubo_context` into the solution tables of state.  Once state holds the result of a solve
+// it resumes from it: the outer loop starts from the solution of state and the solutions already
+// found, rather than from a random start.  A resumed solve runs a single island.
+void solve_qubo_state(qbsolv_context_t* ctx, const qubo_matrix_t* qubo, qbsolv_state_t* state, parameters_t* param);
+
+// Solve num_qubos independent QUBOs, num_workers of them at the same time, each worker reusing its
+// solution tables from one QUBO to the next.  Every solve runs with the options of ctx, prints
+// nothing, and has a seed of its own drawn from ctx->seed, so the results do not depend on
+// num_workers.  Each solve is a single island on one thread, without param's progress callback
+// and initial solutions.  The best solutions are written one after the other to solutions, which
+// holds the sum of the sizes of the QUBOs, and their energies to energies.
+void solve_qubo_batch(const qbsolv_context_t* ctx, const qubo_matrix_t* qubos, int num_qubos, int QLEN,
+                      const parameters_t* param, int num_workers, int8_t* solutions, double* energies);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,7 @@ cdef extern from "stdheaders_shim.h":
     # missing from older Microsoft c compilers.
     ctypedef char int8_t
     ctypedef long long int64_t
+    ctypedef unsigned long long uint64_t
     ctypedef int int32_t
 
 cdef extern from "qbsolv.h":
@@ -27,14 +28,33 @@ cdef extern from "qbsolv.h":
 
     parameters_t default_parameters()
 
+    cdef struct qbsolv_context_t:
+        int32_t verbose
+        bint find_max
+        char algo[4]
+        bint target_set
+        double target
+        double timeout
+        int32_t tabu_tenure
+        bint write_matrix
+        FILE *out
+        int32_t num_outputs
+        uint64_t seed
+
+    qbsolv_context_t default_context()
+
     void solve(double **qubo, const int qubo_size, int8_t **solution_list,
                double *energy_list, int *solution_counts, int *Qindex, int QLEN,
                parameters_t *param)
 
+    void solve_context(qbsolv_context_t *ctx, double **qubo, const int qubo_size, int8_t **solution_list,
+                       double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param)
+
     void dw_sub_sample(double**, int, int8_t*, void*)
 
 cdef extern from "util.h":
     void  **malloc2D(unsigned int rows, unsigned int cols, unsigned int size)
+    void  **malloc2D_triangular(unsigned int n, unsigned int size)
 
 
 cdef extern from "extern.h":
@@ -42,9 +42,9 @@ class QBSolv(dimod.core.sampler.Sampler):
         """Sample low-energy states defined by a QUBO using qbsolv.
 
         Note:
-            The qbsolv library being shared by all instances of this class is
-            non-reentrant and not thread safe. The GIL should not be released
-            by this method until that is resolved.
+            Each call solves with options and random numbers of its own, so
+            calls do not disturb one another. The GIL is still held for the
+            length of a call, Python sub-problem solvers being called from it.
 
         Note:
             The default build of this library doesn't have the dw library.
@@ -3,13 +3,12 @@ import sys
 import random
 import logging
 
-from libc.stdio cimport stdout
-from libc.stdlib cimport malloc, free, srand
+from libc.stdlib cimport malloc, free
 
-from dwave_qbsolv.cqbsolv cimport int8_t, int64_t, int32_t
+from dwave_qbsolv.cqbsolv cimport int8_t, int64_t, int32_t, uint64_t
 from dwave_qbsolv.cqbsolv cimport default_parameters, dw_init, dw_close, dw_sub_sample
-from dwave_qbsolv.cqbsolv cimport Verbose_, algo_, outFile_, Time_, Tlist_, numsolOut_, WriteMatrix_, TargetSet_, Target_, findMax_
-from dwave_qbsolv.cqbsolv cimport solve, malloc2D
+from dwave_qbsolv.cqbsolv cimport qbsolv_context_t, default_context, Verbose_
+from dwave_qbsolv.cqbsolv cimport solve_context, malloc2D, malloc2D_triangular
 
 ENERGY_IMPACT = 0
 SOLUTION_DIVERSITY = 1
@@ -79,65 +78,43 @@ def run_qbsolv(Q, num_repeats=50, seed=17932241798878,  verbosity=-1,
     else:
         raise ValueError("Invalid value for solver argument {}".format(solver))
 
-    # qbsolv relies on a number of global variables that need to be set before the algorithm can
-    # be run, so let's go ahead and set them here.
-
-    # some of the global variables are changed based on input parameters
+    # the run options go in a context of this call's own, defaults are those of the command line
+    # program: printing to stdout, default tabu tenure, no matrix print out
+    cdef qbsolv_context_t ctx = default_context()
+    ctx.verbose = verbosity
     global Verbose_
-    Verbose_ = verbosity
+    Verbose_ = verbosity  # the dw interface still reads its verbosity from the global
 
-    global algo_
     cdef int n_solutions = 20  # the maximimum number of solutions returned
     if algorithm is None or algorithm == ENERGY_IMPACT:
-        algo_[0] = "o"
-        algo_[1] = 0
+        ctx.algo[0] = "o"
+        ctx.algo[1] = 0
         # n_solutions = 20
     elif algorithm == SOLUTION_DIVERSITY:
-        algo_[0] = "d"
-        algo_[1] = 0
+        ctx.algo[0] = "d"
+        ctx.algo[1] = 0
         n_solutions = 70
     else:
         raise ValueError('unknown algorithm given')
 
     if timeout <= 0:
         raise ValueError("'timeout' must be positive")
-    global Time_
-    Time_ = timeout # the maximum runtime of the algorithm in seconds before timeout (2592000 = a month's worth of seconds)
-
-    # other global variables are fixed for our purposes here
-
-    global outFile_
-    outFile_ = stdout
-
-    global Tlist_
-    Tlist_ = -1
-
-    global numsolOut_
-    numsolOut_ = 0
-
-    global WriteMatrix_
-    WriteMatrix_ = False
-
-    global TargetSet_
-    TargetSet_ = False
+    ctx.timeout = timeout # the maximum runtime of the algorithm in seconds before timeout (2592000 = a month's worth of seconds)
 
-    global findMax_
-    findMax_ = bool(find_max)
+    ctx.find_max = bool(find_max)
 
     if target is not None:
-        TargetSet_ = True
-        global Target_
-        Target_ = target
+        ctx.target_set = True
+        ctx.target = target
 
     # we also take the opportunity to set the random seed used by qbsolv. Qbsolv has a default random seed
     # so we mimic that behaviour here.
     if seed is None:
         seed = random.randint(0, 1L<<30)
         log.debug('setting random seed to %d', seed)
-    cdef int64_t c_seed = seed
-    srand(c_seed)
+    ctx.seed = <uint64_t>(<int64_t>seed)
 
-    # ok, all of the globals are set, so let's get to actually solving the given problem. First we need the
+    # ok, all of the options are set, so let's get to actually solving the given problem. First we need the
     # list of variables used by Q
     variables = set().union(*Q)
 
@@ -148,10 +125,10 @@ def run_qbsolv(Q, num_repeats=50, seed=17932241798878,  verbosity=-1,
     cdef int *solution_counts = <int *>malloc((n_solutions + 1) * sizeof(int))
     cdef int *Qindex = <int *>malloc((n_solutions + 1) * sizeof(int))
 
-    # create a matrix and set everything to 0
-    cdef double **Q_array = <double **>malloc2D(n_variables, n_variables, sizeof(double))
+    # create a packed upper triangular matrix and set everything to 0
+    cdef double **Q_array = <double **>malloc2D_triangular(n_variables, sizeof(double))
     for row in range(n_variables):
-        for col in range(n_variables):
+        for col in range(row, n_variables):
             Q_array[row][col] = 0.
 
 
@@ -169,7 +146,7 @@ def run_qbsolv(Q, num_repeats=50, seed=17932241798878,  verbosity=-1,
             Q_array[u][v] = sign * bias
 
     # Ok, solve using qbsolv! This puts the answer into output_sample
-    solve(Q_array, n_variables, solution_list, energy_list, solution_counts, Qindex, n_solutions, &params)
+    solve_context(&ctx, Q_array, n_variables, solution_list, energy_list, solution_counts, Qindex, n_solutions, &params)
 
     # we are interested in three things: the samples, the energies, and the
     # number of times each sample appeared
@@ -49,6 +49,9 @@ extensions = [Extension('dwave_qbsolv.qbsolv_binding',
                         ['python/dwave_qbsolv/qbsolv_binding' + ext,
                          './python/globals.cc',
                          './src/solver.cc',
+                         './src/simd.cc',
+                         './src/sub_solver.cc',
+                         './src/thread_pool.cc',
                          './src/dwsolv.cc',
                          './src/util.cc'],
                         include_dirs=['./python', './src', './include', './cmd']
@@ -41,6 +41,11 @@
 #define CPSECONDS ((double)(clock() - start_) / CLOCKS_PER_SEC)
 #define DLT printf("%lf seconds ", CPSECONDS);
 #define uint unsigned int
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(P) __builtin_prefetch(P)
+#else
+#define PREFETCH(P)
+#endif
 #if _WIN32
 #define LONGFORMAT "lld"
 #elif defined(__unix__) || defined(__HAIKU__)
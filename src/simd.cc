@@ -0,0 +1,474 @@
+/*
+ Copyright 2017 D-Wave Systems Inc
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "simd.h"
+#include "solver.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QBSOLV_SIMD_X86 1
+#include <immintrin.h>
+// the AVX-512 intrinsics of some gcc versions start from _mm512_undefined values
+#if !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The vector kernels below work on the 0/1 int8_t solution directly. The factor
+// (solution[ii] - !solution[ii]) of the scalar bit flip update is only ever a sign, so
+// it is applied by xor-ing the sign bit of the coupler, which is exact: every flip_cost
+// update gives the same bits as the scalar kernels. The full evaluations also take the
+// masked row sums four or eight lanes at a time, which changes the order of those
+// additions, so for coefficients that are not integers they can differ from the scalar
+// results in the last bits.
+
+static const simd_kernels_t scalar_kernels = {SIMD_SCALAR,
+                                              "scalar",
+                                              evaluate,
+                                              evaluate_1bit,
+                                              evaluate_symmetric,
+                                              evaluate_1bit_symmetric,
+                                              evaluate_1bit_float};
+
+#ifdef QBSOLV_SIMD_X86
+
+// flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]) for ii in [begin, end) when flip is 1,
+// or -= when flip is 0; the strided column half of the dense kernel uses the same form
+#define SCALAR_FLIP_UPDATE(row_ii, ii) flip_cost[ii] += ((solution[ii] ^ flip) & 1) ? -(double)(row_ii) : (row_ii)
+
+// sign bits of solution[ii..ii+3] as 64 bit lanes, set where the coupler is subtracted
+__attribute__((target("avx2"))) static inline __m256d spin_sign_avx2(const int8_t *solution, __m256i flip) {
+    int32_t bytes;
+    memcpy(&bytes, solution, sizeof(bytes));
+    __m256i spins = _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(bytes));
+    return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_xor_si256(spins, flip), 63));
+}
+
+// all ones lanes where solution[ii..ii+3] is 1
+__attribute__((target("avx2"))) static inline __m256d spin_mask_avx2(const int8_t *solution) {
+    int32_t bytes;
+    memcpy(&bytes, solution, sizeof(bytes));
+    __m256i spins = _mm256_cvtepi8_epi64(_mm_cvtsi32_si128(bytes));
+    return _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_setzero_si256(), spins));
+}
+
+__attribute__((target("avx2"))) static inline double sum_avx2(__m256d acc) {
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+// sum of row[jj] over jj in [begin, end) with solution[jj] == 1
+__attribute__((target("avx2"))) static double masked_sum_avx2(const double *row, const int8_t *solution, uint begin,
+                                                              uint end) {
+    __m256d acc = _mm256_setzero_pd();
+    uint jj = begin;
+    for (; jj + 4 <= end; jj += 4)
+        acc = _mm256_add_pd(acc, _mm256_and_pd(_mm256_loadu_pd(row + jj), spin_mask_avx2(solution + jj)));
+
+    double sum = sum_avx2(acc);
+    for (; jj < end; jj++)
+        if (solution[jj]) sum += row[jj];
+    return sum;
+}
+
+// SCALAR_FLIP_UPDATE over [begin, end) of a contiguous double row
+__attribute__((target("avx2"))) static void flip_update_avx2(const double *row, const int8_t *solution,
+                                                             double *flip_cost, uint begin, uint end, int flip) {
+    const __m256i flip_lanes = _mm256_set1_epi64x(flip);
+    uint ii = begin;
+    for (; ii + 4 <= end; ii += 4) {
+        __m256d delta = _mm256_xor_pd(_mm256_loadu_pd(row + ii), spin_sign_avx2(solution + ii, flip_lanes));
+        _mm256_storeu_pd(flip_cost + ii, _mm256_add_pd(_mm256_loadu_pd(flip_cost + ii), delta));
+    }
+    for (; ii < end; ii++) SCALAR_FLIP_UPDATE(row[ii], ii);
+}
+
+// SCALAR_FLIP_UPDATE over [begin, end) of a contiguous float row
+__attribute__((target("avx2"))) static void flip_update_float_avx2(const float *row, const int8_t *solution,
+                                                                   double *flip_cost, uint begin, uint end,
+                                                                   int flip) {
+    const __m256i flip_lanes = _mm256_set1_epi64x(flip);
+    uint ii = begin;
+    for (; ii + 4 <= end; ii += 4) {
+        __m256d coupler = _mm256_cvtps_pd(_mm_loadu_ps(row + ii));
+        __m256d delta = _mm256_xor_pd(coupler, spin_sign_avx2(solution + ii, flip_lanes));
+        _mm256_storeu_pd(flip_cost + ii, _mm256_add_pd(_mm256_loadu_pd(flip_cost + ii), delta));
+    }
+    for (; ii < end; ii++) SCALAR_FLIP_UPDATE(row[ii], ii);
+}
+
+// evaluate on AVX2
+//
+// The column sums of the upper triangular matrix are gathered a row at a time into
+// flip_cost, so the matrix is only read along its rows. Each column still receives its
+// terms in increasing row order, as in the scalar kernel.
+__attribute__((target("avx2"))) static double evaluate_avx2(int8_t *const solution, const uint qubo_size,
+                                                            const double **const qubo, double *const flip_cost) {
+    double result = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) flip_cost[ii] = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const double *const row = qubo[ii];
+        double row_sum;
+
+        if (solution[ii] == 1) {
+            __m256d acc = _mm256_setzero_pd();
+            uint jj = ii + 1;
+            for (; jj + 4 <= qubo_size; jj += 4) {
+                __m256d coupler = _mm256_loadu_pd(row + jj);
+                acc = _mm256_add_pd(acc, _mm256_and_pd(coupler, spin_mask_avx2(solution + jj)));
+                _mm256_storeu_pd(flip_cost + jj, _mm256_add_pd(_mm256_loadu_pd(flip_cost + jj), coupler));
+            }
+            row_sum = sum_avx2(acc);
+            for (; jj < qubo_size; jj++) {
+                if (solution[jj]) row_sum += row[jj];
+                flip_cost[jj] += row[jj];
+            }
+        } else {
+            row_sum = masked_sum_avx2(row, solution, ii + 1, qubo_size);
+        }
+
+        double contrib = row_sum + flip_cost[ii] + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// evaluate_1bit on AVX2, the strided column half stays scalar
+__attribute__((target("avx2"))) static double evaluate_1bit_avx2(const double old_energy, const uint bit,
+                                                                 int8_t *const solution, const uint qubo_size,
+                                                                 const double **const qubo, double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    for (uint ii = 0; ii < bit; ii++) SCALAR_FLIP_UPDATE(qubo[ii][bit], ii);
+    flip_update_avx2(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+// evaluate_symmetric on AVX2
+__attribute__((target("avx2"))) static double evaluate_symmetric_avx2(int8_t *const solution, const uint qubo_size,
+                                                                      const double **const qubo,
+                                                                      double *const flip_cost) {
+    double result = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const double *const row = qubo[ii];
+        double row_sum = masked_sum_avx2(row, solution, ii + 1, qubo_size);
+        double col_sum = masked_sum_avx2(row, solution, 0, ii);
+
+        double contrib = row_sum + col_sum + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// evaluate_1bit_symmetric on AVX2
+__attribute__((target("avx2"))) static double evaluate_1bit_symmetric_avx2(const double old_energy, const uint bit,
+                                                                           int8_t *const solution,
+                                                                           const uint qubo_size,
+                                                                           const double **const qubo,
+                                                                           double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    flip_update_avx2(qubo[bit], solution, flip_cost, 0, bit, flip);
+    flip_update_avx2(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+// evaluate_1bit_float on AVX2
+__attribute__((target("avx2"))) static double evaluate_1bit_float_avx2(const double old_energy, const uint bit,
+                                                                       int8_t *const solution, const uint qubo_size,
+                                                                       const float **const qubo,
+                                                                       double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    flip_update_float_avx2(qubo[bit], solution, flip_cost, 0, bit, flip);
+    flip_update_float_avx2(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+static const simd_kernels_t avx2_kernels = {SIMD_AVX2,
+                                            "avx2",
+                                            evaluate_avx2,
+                                            evaluate_1bit_avx2,
+                                            evaluate_symmetric_avx2,
+                                            evaluate_1bit_symmetric_avx2,
+                                            evaluate_1bit_float_avx2};
+
+// The AVX-512 kernels are the AVX2 ones eight lanes wide, using mask registers for the
+// masked sums.
+
+// sign bits of solution[ii..ii+7] as 64 bit lanes, set where the coupler is subtracted
+__attribute__((target("avx512f"))) static inline __m512i spin_sign_avx512(const int8_t *solution, __m512i flip) {
+    __m512i spins = _mm512_cvtepi8_epi64(_mm_loadl_epi64((const __m128i *)solution));
+    return _mm512_slli_epi64(_mm512_xor_si512(spins, flip), 63);
+}
+
+// lanes where solution[ii..ii+7] is 1
+__attribute__((target("avx512f"))) static inline __mmask8 spin_mask_avx512(const int8_t *solution) {
+    __m512i spins = _mm512_cvtepi8_epi64(_mm_loadl_epi64((const __m128i *)solution));
+    return _mm512_test_epi64_mask(spins, spins);
+}
+
+// sum of row[jj] over jj in [begin, end) with solution[jj] == 1
+__attribute__((target("avx512f"))) static double masked_sum_avx512(const double *row, const int8_t *solution,
+                                                                   uint begin, uint end) {
+    __m512d acc = _mm512_setzero_pd();
+    uint jj = begin;
+    for (; jj + 8 <= end; jj += 8)
+        acc = _mm512_mask_add_pd(acc, spin_mask_avx512(solution + jj), acc, _mm512_loadu_pd(row + jj));
+
+    double sum = _mm512_reduce_add_pd(acc);
+    for (; jj < end; jj++)
+        if (solution[jj]) sum += row[jj];
+    return sum;
+}
+
+// SCALAR_FLIP_UPDATE over [begin, end) of a contiguous double row
+__attribute__((target("avx512f"))) static void flip_update_avx512(const double *row, const int8_t *solution,
+                                                                  double *flip_cost, uint begin, uint end, int flip) {
+    const __m512i flip_lanes = _mm512_set1_epi64(flip);
+    uint ii = begin;
+    for (; ii + 8 <= end; ii += 8) {
+        __m512i coupler = _mm512_castpd_si512(_mm512_loadu_pd(row + ii));
+        __m512d delta = _mm512_castsi512_pd(_mm512_xor_si512(coupler, spin_sign_avx512(solution + ii, flip_lanes)));
+        _mm512_storeu_pd(flip_cost + ii, _mm512_add_pd(_mm512_loadu_pd(flip_cost + ii), delta));
+    }
+    for (; ii < end; ii++) SCALAR_FLIP_UPDATE(row[ii], ii);
+}
+
+// SCALAR_FLIP_UPDATE over [begin, end) of a contiguous float row
+__attribute__((target("avx512f"))) static void flip_update_float_avx512(const float *row, const int8_t *solution,
+                                                                        double *flip_cost, uint begin, uint end,
+                                                                        int flip) {
+    const __m512i flip_lanes = _mm512_set1_epi64(flip);
+    uint ii = begin;
+    for (; ii + 8 <= end; ii += 8) {
+        __m512i coupler = _mm512_castpd_si512(_mm512_cvtps_pd(_mm256_loadu_ps(row + ii)));
+        __m512d delta = _mm512_castsi512_pd(_mm512_xor_si512(coupler, spin_sign_avx512(solution + ii, flip_lanes)));
+        _mm512_storeu_pd(flip_cost + ii, _mm512_add_pd(_mm512_loadu_pd(flip_cost + ii), delta));
+    }
+    for (; ii < end; ii++) SCALAR_FLIP_UPDATE(row[ii], ii);
+}
+
+// evaluate on AVX-512, see evaluate_avx2
+__attribute__((target("avx512f"))) static double evaluate_avx512(int8_t *const solution, const uint qubo_size,
+                                                                 const double **const qubo, double *const flip_cost) {
+    double result = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) flip_cost[ii] = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const double *const row = qubo[ii];
+        double row_sum;
+
+        if (solution[ii] == 1) {
+            __m512d acc = _mm512_setzero_pd();
+            uint jj = ii + 1;
+            for (; jj + 8 <= qubo_size; jj += 8) {
+                __m512d coupler = _mm512_loadu_pd(row + jj);
+                acc = _mm512_mask_add_pd(acc, spin_mask_avx512(solution + jj), acc, coupler);
+                _mm512_storeu_pd(flip_cost + jj, _mm512_add_pd(_mm512_loadu_pd(flip_cost + jj), coupler));
+            }
+            row_sum = _mm512_reduce_add_pd(acc);
+            for (; jj < qubo_size; jj++) {
+                if (solution[jj]) row_sum += row[jj];
+                flip_cost[jj] += row[jj];
+            }
+        } else {
+            row_sum = masked_sum_avx512(row, solution, ii + 1, qubo_size);
+        }
+
+        double contrib = row_sum + flip_cost[ii] + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// evaluate_1bit on AVX-512, the strided column half stays scalar
+__attribute__((target("avx512f"))) static double evaluate_1bit_avx512(const double old_energy, const uint bit,
+                                                                      int8_t *const solution, const uint qubo_size,
+                                                                      const double **const qubo,
+                                                                      double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    for (uint ii = 0; ii < bit; ii++) SCALAR_FLIP_UPDATE(qubo[ii][bit], ii);
+    flip_update_avx512(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+// evaluate_symmetric on AVX-512
+__attribute__((target("avx512f"))) static double evaluate_symmetric_avx512(int8_t *const solution,
+                                                                           const uint qubo_size,
+                                                                           const double **const qubo,
+                                                                           double *const flip_cost) {
+    double result = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const double *const row = qubo[ii];
+        double row_sum = masked_sum_avx512(row, solution, ii + 1, qubo_size);
+        double col_sum = masked_sum_avx512(row, solution, 0, ii);
+
+        double contrib = row_sum + col_sum + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// evaluate_1bit_symmetric on AVX-512
+__attribute__((target("avx512f"))) static double evaluate_1bit_symmetric_avx512(const double old_energy,
+                                                                                const uint bit,
+                                                                                int8_t *const solution,
+                                                                                const uint qubo_size,
+                                                                                const double **const qubo,
+                                                                                double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    flip_update_avx512(qubo[bit], solution, flip_cost, 0, bit, flip);
+    flip_update_avx512(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+// evaluate_1bit_float on AVX-512
+__attribute__((target("avx512f"))) static double evaluate_1bit_float_avx512(const double old_energy, const uint bit,
+                                                                            int8_t *const solution,
+                                                                            const uint qubo_size,
+                                                                            const float **const qubo,
+                                                                            double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    const int flip = solution[bit] == 0;
+    flip_update_float_avx512(qubo[bit], solution, flip_cost, 0, bit, flip);
+    flip_update_float_avx512(qubo[bit], solution, flip_cost, bit + 1, qubo_size, flip);
+
+    return result;
+}
+
+static const simd_kernels_t avx512_kernels = {SIMD_AVX512,
+                                              "avx512",
+                                              evaluate_avx512,
+                                              evaluate_1bit_avx512,
+                                              evaluate_symmetric_avx512,
+                                              evaluate_1bit_symmetric_avx512,
+                                              evaluate_1bit_float_avx512};
+
+#endif  // QBSOLV_SIMD_X86
+
+// The kernels for level, NULL if this build or the CPU it runs on cannot execute them
+//
+// @param level the instruction set
+// @returns the kernels, or NULL
+const simd_kernels_t *simd_kernels_for(simd_level_t level) {
+    switch (level) {
+        case SIMD_SCALAR:
+            return &scalar_kernels;
+#ifdef QBSOLV_SIMD_X86
+        case SIMD_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+        case SIMD_AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f") ? &avx512_kernels : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+// Pick the kernels for simd_kernels
+//
+// @returns the kernels named by QBSOLV_SIMD if the CPU can run them, else the widest supported
+static const simd_kernels_t *select_kernels(void) {
+    const char *name = getenv("QBSOLV_SIMD");
+    if (name != NULL) {
+        for (int level = SIMD_SCALAR; level <= SIMD_AVX512; level++) {
+            const simd_kernels_t *kernels = simd_kernels_for((simd_level_t)level);
+            if (kernels != NULL && strcmp(name, kernels->name) == 0) return kernels;
+        }
+    }
+
+    for (int level = SIMD_AVX512; level > SIMD_SCALAR; level--) {
+        const simd_kernels_t *kernels = simd_kernels_for((simd_level_t)level);
+        if (kernels != NULL) return kernels;
+    }
+    return &scalar_kernels;
+}
+
+// The kernels used by qubo_evaluate and qubo_evaluate_1bit
+//
+// @returns the kernels, selected on the first call
+const simd_kernels_t *simd_kernels(void) {
+    static const simd_kernels_t *const kernels = select_kernels();
+    return kernels;
+}
+
+#ifdef __cplusplus
+}
+#endif
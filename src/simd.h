@@ -0,0 +1,56 @@
+/*
+ Copyright 2017 D-Wave Systems Inc
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+#pragma once
+
+#include "macros.h"
+#include "stdheaders_shim.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The instruction sets the dense kernels can be dispatched to
+typedef enum simd_level_t { SIMD_SCALAR = 0, SIMD_AVX2 = 1, SIMD_AVX512 = 2 } simd_level_t;
+
+typedef double (*evaluate_kernel)(int8_t *const solution, const uint qubo_size, const double **const qubo,
+                                  double *const flip_cost);
+typedef double (*evaluate_1bit_kernel)(const double old_energy, const uint bit, int8_t *const solution,
+                                       const uint qubo_size, const double **const qubo, double *const flip_cost);
+typedef double (*evaluate_1bit_float_kernel)(const double old_energy, const uint bit, int8_t *const solution,
+                                             const uint qubo_size, const float **const qubo,
+                                             double *const flip_cost);
+
+// One implementation of each of the kernels over full rows of a dense matrix, with the same
+// arguments and results as evaluate, evaluate_1bit, evaluate_symmetric, evaluate_1bit_symmetric
+// and evaluate_1bit_float
+typedef struct simd_kernels_t {
+    simd_level_t level;
+    const char *name;
+    evaluate_kernel evaluate;
+    evaluate_1bit_kernel evaluate_1bit;
+    evaluate_kernel evaluate_symmetric;
+    evaluate_1bit_kernel evaluate_1bit_symmetric;
+    evaluate_1bit_float_kernel evaluate_1bit_float;
+} simd_kernels_t;
+
+// The kernels for level, NULL if this build or the CPU it runs on cannot execute them
+const simd_kernels_t *simd_kernels_for(simd_level_t level);
+
+// The kernels used by qubo_evaluate and qubo_evaluate_1bit, chosen once: the widest instruction
+// set the CPU supports, unless the QBSOLV_SIMD environment variable names another one
+// (scalar, avx2 or avx512)
+const simd_kernels_t *simd_kernels(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,9 +16,16 @@
 #include "extern.h"
 #include "macros.h"
 #include "qbsolv.h"
+#include "simd.h"
+#include "solver.h"
+#include "thread_pool.h"
 #include "util.h"
 
+#include <limits.h>
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #ifdef __cplusplus
 extern "C" {
@@ -147,6 +154,383 @@ double evaluate_1bit(const double old_energy, const uint bit, int8_t *const solu
     return result;
 }
 
+// This function evaluates the objective function for a given solution on a sparse QUBO.
+//
+// Same as evaluate, but the cost is proportional to the number of couplers.
+//
+// @param solution a current solution
+// @param qubo the sparse QUBO being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns Energy of solution evaluated by qubo
+double evaluate_sparse(int8_t *const solution, const sparse_qubo_t *const qubo, double *const flip_cost) {
+    double result = 0.0;
+
+    for (int ii = 0; ii < qubo->size; ii++) {
+        double row_sum = 0.0;
+        double col_sum = 0.0;
+
+        // the columns of a row are sorted, so the couplers to lower variables
+        // come first and play the role of the dense column sum
+        for (int64_t kk = qubo->row_start[ii]; kk < qubo->row_start[ii + 1]; kk++) {
+            int jj = qubo->columns[kk];
+            if (solution[jj]) {
+                if (jj > ii)
+                    row_sum += qubo->values[kk];
+                else
+                    col_sum += qubo->values[kk];
+            }
+        }
+
+        double contrib = row_sum + col_sum + qubo->diagonal[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + qubo->diagonal[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// Flips a given bit in the solution of a sparse QUBO, and calculates the new energy.
+//
+// Same as evaluate_1bit, but only the neighbours of bit are visited.
+//
+// @param old_energy The current objective function value
+// @param bit is the bit to be flipped
+// @param[in,out] solution inputs a current solution, flips the given bit
+// @param qubo the sparse QUBO being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns New energy of the modified solution
+double evaluate_1bit_sparse(const double old_energy, const uint bit, int8_t *const solution,
+                            const sparse_qubo_t *const qubo, double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    // the sign of the change depends on both solution[bit] and solution[ii]
+    const int64_t row_end = qubo->row_start[bit + 1];
+    if (solution[bit] == 0) {
+        for (int64_t kk = qubo->row_start[bit]; kk < row_end; kk++) {
+            int ii = qubo->columns[kk];
+            flip_cost[ii] += qubo->values[kk] * (solution[ii] - !solution[ii]);
+        }
+    } else {
+        for (int64_t kk = qubo->row_start[bit]; kk < row_end; kk++) {
+            int ii = qubo->columns[kk];
+            flip_cost[ii] -= qubo->values[kk] * (solution[ii] - !solution[ii]);
+        }
+    }
+
+    return result;
+}
+
+// This function evaluates the objective function for a given solution on a symmetric QUBO.
+//
+// Same as evaluate, but the couplers to lower variables are read from the
+// mirrored lower triangle, so each variable only walks its own row.
+//
+// @param solution a current solution
+// @param qubo_size the number of variables in the QUBO matrix
+// @param qubo the symmetric QUBO matrix being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns Energy of solution evaluated by qubo
+double evaluate_symmetric(int8_t *const solution, const uint qubo_size, const double **const qubo,
+                          double *const flip_cost) {
+    double result = 0.0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const double *const row = qubo[ii];
+        double row_sum = 0.0;
+        double col_sum = 0.0;
+
+        for (uint jj = ii + 1; jj < qubo_size; jj++)
+            if (solution[jj]) row_sum += row[jj];
+
+        for (uint jj = 0; jj < ii; jj++)
+            if (solution[jj]) col_sum += row[jj];
+
+        double contrib = row_sum + col_sum + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = -contrib;
+        } else {
+            flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// Flips a given bit in the solution of a symmetric QUBO, and calculates the new energy.
+//
+// Same as evaluate_1bit, but all of the flip_cost updates read the one contiguous row of bit.
+//
+// @param old_energy The current objective function value
+// @param bit is the bit to be flipped
+// @param[in,out] solution inputs a current solution, flips the given bit
+// @param qubo_size is the number of variables in the QUBO matrix
+// @param qubo the symmetric QUBO matrix being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns New energy of the modified solution
+double evaluate_1bit_symmetric(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                               const double **const qubo, double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+    const double *const row = qubo[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    if (solution[bit] == 0) {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+    } else {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+    }
+
+    return result;
+}
+
+// Flips a given bit in the solution of a single precision QUBO, and calculates the new energy.
+//
+// Same as evaluate_1bit_symmetric, but the row of bit is read from the mirrored float copy,
+// halving the memory traffic of the update. flip_cost and the energy are still accumulated
+// in double, so the only difference from the double QUBO is the rounding of the couplers.
+//
+// @param old_energy The current objective function value
+// @param bit is the bit to be flipped
+// @param[in,out] solution inputs a current solution, flips the given bit
+// @param qubo_size is the number of variables in the QUBO matrix
+// @param qubo the mirrored single precision QUBO matrix being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns New energy of the modified solution
+double evaluate_1bit_float(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                           const float **const qubo, double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+    const float *const row = qubo[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    if (solution[bit] == 0) {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+    } else {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+    }
+
+    return result;
+}
+
+// This function evaluates the objective function for a given solution on an integer QUBO.
+//
+// Same as evaluate_symmetric, but the sums are accumulated in int64_t from the mirrored int32_t
+// copy, so the energy and flip_cost are exact.
+//
+// @param solution a current solution
+// @param qubo_size the number of variables in the QUBO matrix
+// @param qubo the mirrored integer QUBO matrix being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns Energy of solution evaluated by qubo
+double evaluate_integer(int8_t *const solution, const uint qubo_size, const int32_t **const qubo,
+                        double *const flip_cost) {
+    int64_t result = 0;
+
+    for (uint ii = 0; ii < qubo_size; ii++) {
+        const int32_t *const row = qubo[ii];
+        int64_t row_sum = 0;
+        int64_t col_sum = 0;
+
+        for (uint jj = ii + 1; jj < qubo_size; jj++)
+            if (solution[jj]) row_sum += row[jj];
+
+        for (uint jj = 0; jj < ii; jj++)
+            if (solution[jj]) col_sum += row[jj];
+
+        int64_t contrib = row_sum + col_sum + row[ii];
+        if (solution[ii] == 1) {
+            result += row_sum + row[ii];
+            flip_cost[ii] = (double)-contrib;
+        } else {
+            flip_cost[ii] = (double)contrib;
+        }
+    }
+
+    return (double)result;
+}
+
+// Flips a given bit in the solution of an integer QUBO, and calculates the new energy.
+//
+// Same as evaluate_1bit_symmetric, but the row of bit is read from the mirrored int32_t copy.
+// Every flip_cost stays an integer held exactly in a double, so there is no drift to resync.
+//
+// @param old_energy The current objective function value
+// @param bit is the bit to be flipped
+// @param[in,out] solution inputs a current solution, flips the given bit
+// @param qubo_size is the number of variables in the QUBO matrix
+// @param qubo the mirrored integer QUBO matrix being solved
+// @param[out] flip_cost The change in energy from flipping a bit
+// @returns New energy of the modified solution
+double evaluate_1bit_integer(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                             const int32_t **const qubo, double *const flip_cost) {
+    double result = old_energy + flip_cost[bit];
+    const int32_t *const row = qubo[bit];
+
+    solution[bit] = 1 - solution[bit];
+    flip_cost[bit] = -flip_cost[bit];
+
+    if (solution[bit] == 0) {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] += row[ii] * (solution[ii] - !solution[ii]);
+    } else {
+        for (uint ii = 0; ii < bit; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+        for (uint ii = bit + 1; ii < qubo_size; ii++) flip_cost[ii] -= row[ii] * (solution[ii] - !solution[ii]);
+    }
+
+    return result;
+}
+
+// Evaluates the objective function for a given solution, on any supported layout
+//
+// QUBO_FLOAT is evaluated on its double precision matrix, so every full evaluation
+// also resyncs flip_cost and the energy from any rounding in the single precision updates.
+// The dense layouts run the vector kernels of simd_kernels() when the CPU has them.
+double qubo_evaluate(int8_t *const solution, const qubo_matrix_t *const qubo, double *const flip_cost) {
+    switch (qubo->layout) {
+        case QUBO_SPARSE:
+            return evaluate_sparse(solution, qubo->sparse, flip_cost);
+        case QUBO_SYMMETRIC:
+            return simd_kernels()->evaluate_symmetric(solution, qubo->size, (const double **)qubo->dense, flip_cost);
+        case QUBO_INTEGER:
+            return evaluate_integer(solution, qubo->size, (const int32_t **)qubo->integer, flip_cost);
+        default:
+            return simd_kernels()->evaluate(solution, qubo->size, (const double **)qubo->dense, flip_cost);
+    }
+}
+
+// Flips a given bit in the solution and calculates the new energy, on any supported layout
+double qubo_evaluate_1bit(const double old_energy, const uint bit, int8_t *const solution,
+                          const qubo_matrix_t *const qubo, double *const flip_cost) {
+    switch (qubo->layout) {
+        case QUBO_SPARSE:
+            return evaluate_1bit_sparse(old_energy, bit, solution, qubo->sparse, flip_cost);
+        case QUBO_SYMMETRIC:
+            return simd_kernels()->evaluate_1bit_symmetric(old_energy, bit, solution, qubo->size,
+                                                           (const double **)qubo->dense, flip_cost);
+        case QUBO_FLOAT:
+            return simd_kernels()->evaluate_1bit_float(old_energy, bit, solution, qubo->size,
+                                                       (const float **)qubo->single, flip_cost);
+        case QUBO_INTEGER:
+            return evaluate_1bit_integer(old_energy, bit, solution, qubo->size, (const int32_t **)qubo->integer,
+                                         flip_cost);
+        default:
+            return simd_kernels()->evaluate_1bit(old_energy, bit, solution, qubo->size, (const double **)qubo->dense,
+                                                 flip_cost);
+    }
+}
+
+// Allocate the scratch memory for a solve of size variables in sub QUBOs of sub_size variables
+//
+// @param size the number of variables of the full QUBO
+// @param sub_size the number of variables of the sub QUBOs
+// @returns a workspace to be released with solver_workspace_free
+solver_workspace_t *solver_workspace_create(int size, int sub_size) {
+    solver_workspace_t *work;
+    if (GETMEM(work, solver_workspace_t, 1) == NULL) BADMALLOC
+    work->size = size;
+    work->sub_size = sub_size;
+
+    if (GETMEM(work->order, int, size) == NULL) BADMALLOC
+    if (GETMEM(work->compress, int, sub_size) == NULL) BADMALLOC
+    work->sub_qubo = (double **)malloc2D_aligned(sub_size, sub_size, sizeof(double));
+    if (GETMEM(work->sub_solution, int8_t, sub_size) == NULL) BADMALLOC
+    if (GETMEM(work->sub_flip_cost, double, sub_size) == NULL) BADMALLOC
+    if (GETMEM(work->sub_best, int8_t, sub_size) == NULL) BADMALLOC
+    if (GETMEM(work->sub_tabu, int, sub_size) == NULL) BADMALLOC
+    if (GETMEM(work->sub_index, int, sub_size) == NULL) BADMALLOC
+    if (GETMEM(work->sub_order, int, sub_size) == NULL) BADMALLOC
+    work->tree = NULL;
+    work->solution = NULL;
+    work->tabu_solution = NULL;
+    work->flip_cost = NULL;
+    work->index = NULL;
+    work->tabu = NULL;
+    work->pcompress = NULL;
+    work->pool = NULL;
+    work->pool_rows = 0;
+    work->batch = NULL;
+    return work;
+}
+
+// Allocate the buffers of the outer loop of a workspace, for solution tables of pool_rows rows
+static void workspace_outer_create(solver_workspace_t *work, int pool_rows) {
+    const int size = work->size;
+    if (work->solution == NULL) {
+        if (GETMEM(work->solution, int8_t, size) == NULL) BADMALLOC
+        if (GETMEM(work->tabu_solution, int8_t, size) == NULL) BADMALLOC
+        if (GETMEM(work->flip_cost, double, size) == NULL) BADMALLOC
+        if (GETMEM(work->index, int, size) == NULL) BADMALLOC
+        if (GETMEM(work->tabu, int, size) == NULL) BADMALLOC
+        if (GETMEM(work->pcompress, int, size) == NULL) BADMALLOC
+    }
+    if (work->pool_rows < pool_rows) {
+        solution_pool_free(work->pool);
+        work->pool = solution_pool_create(pool_rows, size);
+        work->pool_rows = pool_rows;
+    }
+}
+
+static void sub_batch_free(struct sub_batch_t *batch);
+
+// Release a workspace created by solver_workspace_create
+void solver_workspace_free(solver_workspace_t *work) {
+    if (work == NULL) return;
+    free(work->order);
+    free(work->compress);
+    free(work->sub_qubo);
+    free(work->sub_solution);
+    free(work->sub_flip_cost);
+    free(work->sub_best);
+    free(work->sub_tabu);
+    free(work->sub_index);
+    free(work->sub_order);
+    move_tree_free(work->tree);
+    free(work->solution);
+    free(work->tabu_solution);
+    free(work->flip_cost);
+    free(work->index);
+    free(work->tabu);
+    free(work->pcompress);
+    solution_pool_free(work->pool);
+    sub_batch_free(work->batch);
+    free(work);
+}
+
+// Wrap an upper triangular 2d array as a QUBO matrix
+qubo_matrix_t dense_qubo_matrix(double **qubo, int qubo_size) {
+    qubo_matrix_t matrix;
+    matrix.layout = QUBO_DENSE;
+    matrix.size = qubo_size;
+    matrix.dense = qubo;
+    matrix.single = NULL;
+    matrix.integer = NULL;
+    matrix.sparse = NULL;
+    return matrix;
+}
+
+// the wall clock seconds since the start of the solve of ctx, as printed and passed to the progress callback
+static double solve_seconds(const qbsolv_context_t *ctx) { return solver_wall_seconds() - ctx->start; }
+
+// true once the solve of ctx is past its deadline or cancelled
+bool solve_stopped(const qbsolv_context_t *ctx) {
+    if (ctx->cancel != NULL && *ctx->cancel != 0) return true;
+    return solver_wall_seconds() >= ctx->deadline;
+}
+
 // Tries to improve the current solution Q by flipping single bits.
 // It flips a bit whenever a bit flip improves the objective function value,
 // terminating when a local optimum is found.
@@ -155,18 +539,20 @@ double evaluate_1bit(const double old_energy, const uint bit, int8_t *const solu
 // This routine does not perform a full evalution of the the state or auxiliary
 // information, it assumes it is already up to date.
 //
+// @param ctx the deadline and cancellation, at which to stop short of the local optimum
 // @param energy The current objective function value
 // @param[in,out] solution inputs a current solution, modified by local search
-// @param[in] size is the number of variables in the QUBO matrix
 // @param[in] qubo the QUBO matrix being solved
 // @param[out] flip_cost The change in energy from flipping a bit
 // @param[in,out] bit_flips is the number of candidate bit flips performed in the entire algorithm so far
+// @param order scratch space of qubo_size entries for the sweep order
 // @returns New energy of the modified solution
-double local_search_1bit(double energy, int8_t *solution, uint qubo_size, double **qubo, double *flip_cost,
-                         int64_t *bit_flips) {
+double local_search_1bit(const qbsolv_context_t *ctx, double energy, int8_t *solution, const qubo_matrix_t *qubo,
+                         double *flip_cost, int64_t *bit_flips, int *order) {
+    const uint qubo_size = qubo->size;
     int kkstr = 0, kkend = qubo_size, kkinc;
-    int *index;
-    if (GETMEM(index, int, qubo_size) == NULL) BADMALLOC
+    int *index = order;
+    int64_t work = 0;  // since the last look at the clock
 
     for (uint kk = 0; kk < qubo_size; kk++) {
         index[kk] = kk;
@@ -192,13 +578,18 @@ double local_search_1bit(double energy, int8_t *solution, uint qubo_size, double
         for (int kk = kkstr; kk != kkend; kk = kk + kkinc) {
             uint bit = index[kk];
             (*bit_flips)++;
+            work++;
             if (flip_cost[bit] > 0.0) {
-                energy = evaluate_1bit(energy, bit, solution, qubo_size, (const double **)qubo, flip_cost);
+                energy = qubo_evaluate_1bit(energy, bit, solution, qubo, flip_cost);
                 improve = true;
+                work += qubo_size;
+            }
+            if (work >= DEADLINE_WORK) {
+                if (solve_stopped(ctx)) return energy;
+                work = 0;
             }
         }
     }
-    free(index);
     return energy;
 }
 
@@ -207,21 +598,38 @@ double local_search_1bit(double energy, int8_t *solution, uint qubo_size, double
 // Mostly the same as local_search_1bit, except it first evaluates the
 // current solution and updates the auxiliary information (flip_cost)
 //
+// @param ctx the deadline and cancellation, at which to stop short of the local optimum
 // @param[in,out] solution inputs a current solution, modified by local search
-// @param size is the number of variables in the QUBO matrix
+// @param qubo the QUBO matrix being solved
 // @param[out] flip_cost The change in energy from flipping a bit
 // @param bit_flips is the number of candidate bit flips performed in the entire algorithm so far
+// @param order scratch space of qubo_size entries for the sweep order
 // @returns New energy of the modified solution
-double local_search(int8_t *solution, int qubo_size, double **qubo, double *flip_cost, int64_t *bit_flips) {
+double local_search(const qbsolv_context_t *ctx, int8_t *solution, const qubo_matrix_t *qubo, double *flip_cost,
+                    int64_t *bit_flips, int *order) {
     double energy;
 
     // initial evaluate needed before evaluate_1bit can be used
-    energy = evaluate(solution, qubo_size, (const double **)qubo, flip_cost);
-    energy = local_search_1bit(energy, solution, qubo_size, qubo, flip_cost,
-                               bit_flips);  // local search to polish the change
+    energy = qubo_evaluate(solution, qubo, flip_cost);
+    energy = local_search_1bit(ctx, energy, solution, qubo, flip_cost, bit_flips,
+                               order);  // local search to polish the change
     return energy;
 }
 
+// Bring a move tree up to date after bit was flipped
+//
+// On a sparse QUBO only bit and its neighbours changed cost, otherwise the whole tree is rebuilt.
+static void move_tree_flipped(struct move_tree *tree, const qubo_matrix_t *qubo, const double *flip_cost, uint bit) {
+    if (qubo->layout == QUBO_SPARSE) {
+        const sparse_qubo_t *sparse = qubo->sparse;
+        move_tree_update(tree, bit);
+        for (int64_t k = sparse->row_start[bit]; k < sparse->row_start[bit + 1]; k++)
+            move_tree_update(tree, sparse->columns[k]);
+    } else {
+        move_tree_build(tree, flip_cost);
+    }
+}
+
 // This function is called by solve to execute a tabu search, This is THE Tabu search
 //
 // A tabu optimization algorithm tries to find an approximately maximal solution
@@ -237,19 +645,30 @@ double local_search(int8_t *solution, int qubo_size, double **qubo, double *flip
 // it cannot be flipped again for another "nTabu" moves. The algorithm terminates
 // after sufficiently many bit flips without improvment.
 //
+// @param ctx the tabu tenure to use when nTabu is 0, the verbosity, the sign of what is printed and
+//        the deadline and cancellation, at which the best solution so far is returned
 // @param[in,out] solution inputs a current solution and returns the best solution found
 // @param[out] best stores the best solution found during the algorithm
-// @param qubo_size is the number of variables in the QUBO matrix
 // @param qubo is the QUBO matrix to be solved
 // @param flip_cost is the impact vector (the change in objective function value that results from flipping each bit)
 // @param bit_flips is the number of candidate bit flips performed in the entire algorithm so far
 // @param iter_max is the maximum size of bit_flips allowed before terminating
-// @param TabuK stores the list of tabu moves
+// @param TabuK stores the list of tabu moves, as the last iteration at which each bit is tabu
 // @param target Halt if this energy is reached and TargetSet is true
 // @param target_set Do we have a target energy at which to terminate
 // @param index is the order in which to perform candidate bit flips (determined by flip_cost).
-double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo, double *flip_cost, int64_t *bit_flips,
-                   int64_t iter_max, int *TabuK, double target, bool target_set, int *index, int nTabu) {
+// @param nTabu is the tabu tenure, 0 to pick one from the size of the QUBO
+// @param order scratch space of qubo_size entries for the local searches
+// @param tree if not NULL, a move tree of qubo_size variables that picks each move in place of the
+//        scan over index, for QUBOs whose bit flips only change a few flip costs (QUBO_SPARSE)
+// @param energy if not NULL, the energy of solution, whose flip costs flip_cost already holds: the
+//        full evaluation at the start is skipped, and at the end the best solution is reached by
+//        flipping the bits it differs in when that is cheaper than evaluating it.  The caller is
+//        then the one to resync flip_cost with a full evaluation now and then, against drift.
+double tabu_search(const qbsolv_context_t *ctx, int8_t *solution, int8_t *best, const qubo_matrix_t *qubo,
+                   double *flip_cost, int64_t *bit_flips, int64_t iter_max, int *TabuK, double target, bool target_set,
+                   int *index, int nTabu, int *order, struct move_tree *tree, const double *energy) {
+    const uint qubo_size = qubo->size;
     uint last_bit = 0;   // Track what the previously flipped bit was
     bool brk;            // flag to mark a break and not a fall-thru of the loop
     double best_energy;  // best solution so far
@@ -259,12 +678,15 @@ double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo
     int64_t increaseIter;
     int numIncrease = 900;
     double howFar;
+    // single precision updates are resynced with a full double evaluation every resync_moves moves
+    const int64_t resync_moves = 16 * (int64_t)qubo_size;
+    int64_t moves_since_resync = 0;
 
     // setup nTabu
     // these nTabu numbers might need to be adjusted to work correctly
     if (nTabu == 0) {  // nTabu not specified on call
-        if (Tlist_ != -1) {
-            nTabu = MIN(Tlist_, (int)qubo_size + 1);  // tabu use set tenure
+        if (ctx->tabu_tenure != -1) {
+            nTabu = MIN(ctx->tabu_tenure, (int)qubo_size + 1);  // tabu use set tenure
         } else {
             if (qubo_size < 20)
                 nTabu = 10;
@@ -285,9 +707,15 @@ double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo
         }
     }
 
-    sign = findMax_ ? 1.0 : -1.0;
+    if (nTabu < 0) nTabu = 0;  // a negative nTabu behaves as 0, all of their tenures last one iteration
+
+    sign = ctx->find_max ? 1.0 : -1.0;
 
-    best_energy = local_search(solution, qubo_size, qubo, flip_cost, bit_flips);
+    if (energy != NULL) {
+        best_energy = local_search_1bit(ctx, *energy, solution, qubo, flip_cost, bit_flips, order);
+    } else {
+        best_energy = local_search(ctx, solution, qubo, flip_cost, bit_flips, order);
+    }
     val_index_sort(index, flip_cost, qubo_size);  // Create index array of sorted values
     thisIter = iter_max - (*bit_flips);
     increaseIter = thisIter / 2;
@@ -296,66 +724,110 @@ double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo
     for (uint i = 0; i < qubo_size; i++) best[i] = solution[i];  // copy the best solution so far
     for (uint i = 0; i < qubo_size; i++) TabuK[i] = 0;           // zero out the Tabu vector
 
+    // bit is tabu while TabuK[bit] >= iteration, so the tenures expire without touching TabuK
+    int iteration = 1;
+    const int history_len = nTabu + 2;  // the tree unmasks the bits moved nTabu + 1 and nTabu - 1 iterations ago
+
+    if (tree != NULL) {
+        move_tree_build(tree, flip_cost);
+        for (uint i = 0; i < qubo_size; i++) move_tree_set_masked(tree, i, false);
+    }
+
     int kk, kkstr = 0, kkend = qubo_size, kkinc;
     uint bit_cycle_1 = qubo_size, bit_cycle_2 = qubo_size, bit_cycle = 0;
     while (*bit_flips < iter_max) {
         // best solution in neighbour, initialized most negative number
         double neighbour_best = BIGNEGFP;
+        double move_energy = 0.0;  // energy after the improving move when brk is set
         brk = false;
-        if (kkstr == 0) {  // sweep top to bottom
-            kkstr = qubo_size - 1;
-            kkinc = -1;
-            kkend = -1;
-        } else {  // sweep bottom to top
-            kkstr = 0;
-            kkinc = 1;
-            kkend = qubo_size;
-        }
 
-        for (kk = kkstr; kk != kkend; kk = kk + kkinc) {
-            uint bit = index[kk];
-            if (TabuK[bit] != (int8_t)0) continue;
-            {
+        if (tree != NULL) {
+            // the root of the tree is the non tabu bit with the largest flip_cost, which is what the
+            // scan below settles on when no bit improves on best_energy; it is charged as a full scan
+            int bit = move_tree_best(tree);
+            if (bit >= 0) {
+                (*bit_flips) += qubo_size - tree->masked_count;
+                move_energy = Vlastchange + flip_cost[bit];
+                if (move_energy > best_energy && (uint)bit == bit_cycle_1) {
+                    // bit_cycle_1 may not be taken as an improvement, the next best bit may
+                    move_tree_set_masked(tree, bit, true);
+                    int next = move_tree_best(tree);
+                    move_tree_set_masked(tree, bit, false);
+                    if (next >= 0 && Vlastchange + flip_cost[next] > best_energy) {
+                        bit = next;
+                        move_energy = Vlastchange + flip_cost[next];
+                        brk = true;
+                    }
+                } else if (move_energy > best_energy) {
+                    brk = true;
+                }
+                last_bit = bit;
+            }
+        } else {
+            if (kkstr == 0) {  // sweep top to bottom
+                kkstr = qubo_size - 1;
+                kkinc = -1;
+                kkend = -1;
+            } else {  // sweep bottom to top
+                kkstr = 0;
+                kkinc = 1;
+                kkend = qubo_size;
+            }
+
+            for (kk = kkstr; kk != kkend; kk = kk + kkinc) {
+                uint bit = index[kk];
+                if (TabuK[bit] >= iteration) continue;
                 (*bit_flips)++;
                 double new_energy = Vlastchange + flip_cost[bit];  //  value if Q[k] bit is flipped
                 if (new_energy > best_energy && bit != bit_cycle_1) {
                     brk = true;
                     last_bit = bit;
-                    float Delta_E = (float)(new_energy - best_energy);
-                    new_energy = evaluate_1bit(Vlastchange, bit, solution, qubo_size, (const double **)qubo,
-                                               flip_cost);  // flip the bit and fix tables
-                    Vlastchange = local_search_1bit(new_energy, solution, qubo_size, qubo, flip_cost,
-                                                    bit_flips);  // local search to polish the change
-                    val_index_sort_ns(index, flip_cost,
-                                      qubo_size);  // update index array of sorted values, don't shuffle index
-                    best_energy = Vlastchange;
-
-                    for (uint i = 0; i < qubo_size; i++) best[i] = solution[i];  // copy the best solution so far
-
-                    howFar = ((double)(iter_max - (*bit_flips)) / (double)thisIter);
-                    if (Verbose_ > 3) {
-                        printf("Tabu new best %lf ,K=%d,last=%d, last_2=%d, cycle=%d,iteration = %" LONGFORMAT
-                               ""
-                               ", %lf, %d\n",
-                               Vlastchange * sign, last_bit, bit_cycle_1, bit_cycle_2, bit_cycle, (int64_t)(*bit_flips),
-                               howFar, brk);
-                    }
-                    if (target_set) {
-                        if (Vlastchange >= (sign * target)) {
-                            break;
-                        }
-                    }
-                    //  trying to capture a non progressive cycle, after update, really not an advance
-                    //  but have flipped a bit in a different place,, sometime a cycle of 3 bit positions
-                    if (Delta_E <= 0.00000001) bit_cycle++;
-                    if (bit_cycle_2 == bit_cycle_1) bit_cycle++;
-                    if (bit_cycle_2 == last_bit) bit_cycle++;
-                    if (bit_cycle > 4) break;
+                    move_energy = new_energy;
+                    break;
+                }
+                // Q vector unchanged
+                if (new_energy > neighbour_best) {  // check for improved neighbour solution
+                    last_bit = bit;                 // record position
+                    neighbour_best = new_energy;    // record neighbour solution value
+                }
+            }
+        }
 
+        if (brk) {  // last_bit improves on the best solution so far, take it
+            float Delta_E = (float)(move_energy - best_energy);
+            double new_energy = qubo_evaluate_1bit(Vlastchange, last_bit, solution, qubo,
+                                                   flip_cost);  // flip the bit and fix tables
+            Vlastchange = local_search_1bit(ctx, new_energy, solution, qubo, flip_cost, bit_flips,
+                                            order);  // local search to polish the change
+            if (tree != NULL) {
+                move_tree_build(tree, flip_cost);
+            } else {
+                val_index_sort_ns(index, flip_cost,
+                                  qubo_size);  // update index array of sorted values, don't shuffle index
+            }
+            best_energy = Vlastchange;
+
+            for (uint i = 0; i < qubo_size; i++) best[i] = solution[i];  // copy the best solution so far
+
+            howFar = ((double)(iter_max - (*bit_flips)) / (double)thisIter);
+            if (ctx->verbose > 3) {
+                printf("Tabu new best %lf ,K=%d,last=%d, last_2=%d, cycle=%d,iteration = %" LONGFORMAT
+                       ""
+                       ", %lf, %d\n",
+                       Vlastchange * sign, last_bit, bit_cycle_1, bit_cycle_2, bit_cycle, (int64_t)(*bit_flips),
+                       howFar, brk);
+            }
+            if (!target_set || Vlastchange < (sign * target)) {
+                //  trying to capture a non progressive cycle, after update, really not an advance
+                //  but have flipped a bit in a different place,, sometime a cycle of 3 bit positions
+                if (Delta_E <= 0.00000001) bit_cycle++;
+                if (bit_cycle_2 == bit_cycle_1) bit_cycle++;
+                if (bit_cycle_2 == last_bit) bit_cycle++;
+                if (bit_cycle <= 4) {
                     bit_cycle_2 = bit_cycle_1;
                     bit_cycle_1 = last_bit;
                     if (howFar < 0.80 && numIncrease > 0) {
-                        if (Verbose_ > 3) {
+                        if (ctx->verbose > 3) {
                             printf("Increase Itermax %" LONGFORMAT ", %" LONGFORMAT "\n", iter_max,
                                    (iter_max + increaseIter));
                         }
@@ -363,12 +835,6 @@ double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo
                         thisIter += increaseIter;
                         numIncrease--;
                     }
-                    break;
-                }
-                // Q vector unchanged
-                if (new_energy > neighbour_best) {  // check for improved neighbour solution
-                    last_bit = bit;                 // record position
-                    neighbour_best = new_energy;    // record neighbour solution value
                 }
             }
         }
@@ -379,28 +845,60 @@ double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo
             }
         }
         if (bit_cycle > 6) break;
+        if (iteration % DEADLINE_ITERATIONS == 0 && solve_stopped(ctx)) break;
 
         if (!brk) {  // this is the fall-thru case and we haven't tripped interior If V> VS test so flip Q[K]
-            Vlastchange = evaluate_1bit(Vlastchange, last_bit, solution, qubo_size, (const double **)qubo, flip_cost);
+            Vlastchange = qubo_evaluate_1bit(Vlastchange, last_bit, solution, qubo, flip_cost);
+            if (tree != NULL) move_tree_flipped(tree, qubo, flip_cost, last_bit);
         }
 
-        uint i;
-        for (i = 0; i < qubo_size; i++) TabuK[i] = MAX(0, TabuK[i] - 1);
-
         // add some asymmetry
-        if (solution[qubo_size - 1] == 0) {
-            TabuK[last_bit] = nTabu + 1;
-        } else {
-            TabuK[last_bit] = nTabu - 1;
+        int tenure = solution[qubo_size - 1] == 0 ? nTabu + 1 : nTabu - 1;
+        if (tenure < 0) tenure = 1;  // a negative TabuK count used to stay tabu for one iteration
+        TabuK[last_bit] = iteration + tenure;
+
+        if (tree != NULL) {
+            move_tree_set_masked(tree, last_bit, tenure > 0);
+            tree->history[iteration % history_len] = last_bit;
+            // the tenures are nTabu + 1 and nTabu - 1, so only these two bits can expire now
+            for (int age = nTabu - 1; age <= nTabu + 1; age += 2) {
+                if (age < 0 || age >= iteration) continue;
+                int expired = tree->history[(iteration - age) % history_len];
+                if (TabuK[expired] == iteration) move_tree_set_masked(tree, expired, false);
+            }
+        }
+
+        if (++iteration == INT_MAX / 2) {
+            // shift the clock back by whole turns of the history before it can overflow
+            int shift = (iteration / history_len - 1) * history_len;
+            for (uint i = 0; i < qubo_size; i++) TabuK[i] = MAX(0, TabuK[i] - shift);
+            iteration -= shift;
+        }
+
+        if (qubo->layout == QUBO_FLOAT && ++moves_since_resync >= resync_moves) {
+            Vlastchange = qubo_evaluate(solution, qubo, flip_cost);
+            if (tree != NULL) move_tree_build(tree, flip_cost);
+            moves_since_resync = 0;
         }
     }
 
-    // copy over the best solution
-    for (uint i = 0; i < qubo_size; i++) solution[i] = best[i];
+    // go back to the best solution
+    double final_energy;
+    uint differ = 0;
+    for (uint i = 0; i < qubo_size; i++) differ += solution[i] != best[i];
+    if (energy != NULL && qubo->layout != QUBO_FLOAT && differ < qubo_size / 4) {
+        // each flip is O(qubo_size) against O(qubo_size^2) for the evaluation
+        final_energy = Vlastchange;
+        for (uint i = 0; i < qubo_size; i++) {
+            if (solution[i] != best[i]) final_energy = qubo_evaluate_1bit(final_energy, i, solution, qubo, flip_cost);
+        }
+    } else {
+        for (uint i = 0; i < qubo_size; i++) solution[i] = best[i];
 
-    // ok, we are leaving Tabu, we can do a for-sure clean-up run of evaluate, to be sure we
-    // return the true evaluation of the function (given that we only do this a handful of times)
-    double final_energy = evaluate(solution, qubo_size, (const double **)qubo, flip_cost);
+        // ok, we are leaving Tabu, we can do a for-sure clean-up run of evaluate, to be sure we
+        // return the true evaluation of the function (given that we only do this a handful of times)
+        final_energy = qubo_evaluate(solution, qubo, flip_cost);
+    }
 
     // Create index array of sorted values
     val_index_sort(index, flip_cost, qubo_size);
@@ -476,19 +974,157 @@ void reduce(int *Icompress, double **qubo, uint sub_qubo_size, uint qubo_size, d
     return;
 }
 
+// reduce_sparse() computes a subQUBO from a large sparse QUBO, see reduce().
+//
+// The columns of each row and Icompress are both sorted, so the neighbours of
+// an extracted variable are split into subQUBO entries and clamped variables
+// by merging the two lists, at a cost of O(degree + sub_qubo_size) per variable.
+//
+// @param Icompress is the list of variables in the subregion that will be extracted, in increasing order
+// @param qubo is the large sparse QUBO to be solved
+// @param sub_qubo_size is the number of variable in the subregion
+// @param[out] sub_qubo is the returned subQUBO
+// @param[out] sub_solution is a current solution on the subQUBO
+void reduce_sparse(int *Icompress, const sparse_qubo_t *qubo, uint sub_qubo_size, double **sub_qubo,
+                   int8_t *solution, int8_t *sub_solution) {
+    for (uint i = 0; i < sub_qubo_size; i++) {
+        for (uint j = 0; j < sub_qubo_size; j++) sub_qubo[i][j] = 0.0;
+    }
+
+    for (uint i = 0; i < sub_qubo_size; i++) {
+        int variable = Icompress[i];
+        double clamp = 0;
+        uint ji = 0;
+
+        sub_solution[i] = solution[variable];
+        for (int64_t kk = qubo->row_start[variable]; kk < qubo->row_start[variable + 1]; kk++) {
+            int j = qubo->columns[kk];
+            while (ji < sub_qubo_size && Icompress[ji] < j) ji++;
+            if (ji < sub_qubo_size && Icompress[ji] == j) {
+                // a sub_qubo element, every coupler is stored in both rows so keep the upper one
+                if (ji > i) sub_qubo[i][ji] += qubo->values[kk];
+            } else {
+                clamp += qubo->values[kk] * solution[j];
+            }
+        }
+        sub_qubo[i][i] = qubo->diagonal[variable] + clamp;
+    }
+}
+
+// reduce_symmetric() computes a subQUBO from a large symmetric QUBO, see reduce().
+//
+// The clamp of each extracted variable is read from its own contiguous row.
+//
+// @param Icompress is the list of variables in the subregion that will be extracted, in increasing order
+// @param qubo is the large symmetric QUBO matrix to be solved
+// @param sub_qubo_size is the number of variable in the subregion
+// @param qubo_size is the number of variables in the large QUBO matrix
+// @param[out] sub_qubo is the returned subQUBO
+// @param[out] sub_solution is a current solution on the subQUBO
+void reduce_symmetric(int *Icompress, double **qubo, uint sub_qubo_size, uint qubo_size, double **sub_qubo,
+                      int8_t *solution, int8_t *sub_solution) {
+    for (uint i = 0; i < sub_qubo_size; i++) {
+        const double *const row = qubo[Icompress[i]];
+        double clamp = 0;
+        uint ji = 0;
+
+        sub_solution[i] = solution[Icompress[i]];
+        for (uint j = 0; j < sub_qubo_size; j++) sub_qubo[i][j] = 0.0;
+
+        // walk the whole row, skipping the extracted variables
+        for (uint j = 0; j < qubo_size; j++) {
+            if (ji < sub_qubo_size && (int)j == Icompress[ji]) {
+                if (ji >= i) sub_qubo[i][ji] = row[j];
+                ji++;
+            } else {
+                clamp += row[j] * solution[j];
+            }
+        }
+        sub_qubo[i][i] += clamp;
+    }
+}
+
+// reduce_flip_cost() computes the same subQUBO as reduce() from the flip costs of solution.
+//
+// flip_cost already holds the whole local field of every variable, so rather than summing the
+// clamp over all qubo_size columns the couplings inside the subregion are taken back out of it,
+// O(sub_qubo_size^2) in place of O(sub_qubo_size * qubo_size).  The sums come out in another
+// order than reduce(), so they agree exactly on integer QUBOs and to rounding otherwise.
+//
+// The upper triangle is gathered a row at a time, and while a row is read the same columns of
+// the next row are prefetched, as every one of them is likely a cache line of its own.
+//
+// @param Icompress is the list of variables in the subregion that will be extracted, in increasing order
+// @param qubo is the large QUBO, with the couplers in the upper triangle of dense
+// @param sub_qubo_size is the number of variable in the subregion
+// @param[out] sub_qubo is the returned subQUBO
+// @param solution the current solution
+// @param[out] sub_solution is a current solution on the subQUBO
+// @param flip_cost the flip costs of solution, as set by qubo_evaluate
+void reduce_flip_cost(int *Icompress, const qubo_matrix_t *qubo, uint sub_qubo_size, double **sub_qubo,
+                      int8_t *solution, int8_t *sub_solution, const double *flip_cost) {
+    // start each diagonal from the local field of the variable, its linear term included
+    for (uint i = 0; i < sub_qubo_size; i++) {
+        int variable = Icompress[i];
+        sub_solution[i] = solution[variable];
+        sub_qubo[i][i] = sub_solution[i] ? -flip_cost[variable] : flip_cost[variable];
+    }
+
+    for (uint i = 0; i < sub_qubo_size; i++) {
+        const double *const row = qubo->dense[Icompress[i]];
+        const double *const next = qubo->dense[Icompress[i + 1 < sub_qubo_size ? i + 1 : i]];
+        double *const sub_row = sub_qubo[i];
+
+        for (uint j = 0; j < i; j++) sub_row[j] = 0.0;
+        for (uint j = i + 1; j < sub_qubo_size; j++) {
+            PREFETCH(&next[Icompress[j]]);
+            double coupler = row[Icompress[j]];
+            sub_row[j] = coupler;
+            // the extracted variables are free in the subQUBO, so they are not part of the clamp
+            if (sub_solution[j]) sub_row[i] -= coupler;
+            if (sub_solution[i]) sub_qubo[j][j] -= coupler;
+        }
+    }
+}
+
+// true if reduce_flip_cost() applies to the layout of qubo
+//
+// A sparse QUBO already reduces in O(degree) per variable, and the flip costs of a float QUBO
+// carry single precision rounding, so both keep their own reduce.
+bool reduce_flip_cost_layout(const qubo_matrix_t *qubo) {
+    return qubo->layout == QUBO_DENSE || qubo->layout == QUBO_SYMMETRIC || qubo->layout == QUBO_INTEGER;
+}
+
+// Computes a subQUBO from a large QUBO in any of the supported layouts, see reduce()
+void qubo_reduce(int *Icompress, const qubo_matrix_t *qubo, uint sub_qubo_size, double **sub_qubo, int8_t *solution,
+                 int8_t *sub_solution) {
+    switch (qubo->layout) {
+        case QUBO_SPARSE:
+            reduce_sparse(Icompress, qubo->sparse, sub_qubo_size, sub_qubo, solution, sub_solution);
+            break;
+        case QUBO_SYMMETRIC:
+            reduce_symmetric(Icompress, qubo->dense, sub_qubo_size, qubo->size, sub_qubo, solution, sub_solution);
+            break;
+        default:
+            reduce(Icompress, qubo->dense, sub_qubo_size, qubo->size, sub_qubo, solution, sub_solution);
+    }
+}
+
 // solv_submatrix() performs QUBO optimization on a subregion.
 // In this function the subregion is optimized using tabu_search() rather than using the D-Wave hardware.
 //
+// @param ctx the verbosity and sign of what is printed
 // @param[in,out] solution inputs a current solution and returns the best solution found
 // @param[out] best stores the best solution found during the algorithm
-// @param qubo_size is the number of variables in the QUBO matrix
 // @param qubo is the QUBO matrix to be solved
 // @param flip_cost is the impact vector (the change in objective function value that results from flipping each bit)
 // @param bit_flips is the number of candidate bit flips performed in the entire algorithm so far
 // @param TabuK stores the list of tabu moves
 // @param index is the order in which to perform candidate bit flips (determined by Qval).
-double solv_submatrix(int8_t *solution, int8_t *best, uint qubo_size, double **qubo, double *flip_cost,
-                      int64_t *bit_flips, int *TabuK, int *index) {
+// @param order scratch space of qubo_size entries for the local searches
+double solv_submatrix(const qbsolv_context_t *ctx, int8_t *solution, int8_t *best, const qubo_matrix_t *qubo,
+                      double *flip_cost, int64_t *bit_flips, int *TabuK, int *index, int *order) {
+    const uint qubo_size = qubo->size;
     int nTabu;
     int64_t iter_max = (*bit_flips) + (int64_t)MAX((int64_t)3000, (int64_t)20000 * (int64_t)qubo_size);
     if (qubo_size < 20)
@@ -508,28 +1144,32 @@ double solv_submatrix(int8_t *solution, int8_t *best, uint qubo_size, double **q
     else /*qubo_size >= 8000*/
         nTabu = 35;
 
-    return tabu_search(solution, best, qubo_size, qubo, flip_cost, bit_flips, iter_max, TabuK, Target_, false, index,
-                       nTabu);
+    return tabu_search(ctx, solution, best, qubo, flip_cost, bit_flips, iter_max, TabuK, 0.0, false, index, nTabu,
+                       order, NULL, NULL);
 }
-// reduce_solv_projection reduces from a submatrix solves the QUBO projects the solution and
-//      returns the number of changes
+// reduce_solve extracts the sub QUBO of the variables Icompress from qubo, clamped at solution,
+//      and solves it into work->sub_solution, leaving solution alone
+// @param ctx the verbosity and sign of what is printed
 // @param Icompress index vector , ordered lowest to highest, of the row/columns to extract subQubo
 // @param qubo is the QUBO matrix to extract from
-// @param qubo_size is the number of variables in the QUBO matrix
 // @param subMatrix is the size of the subMatrix to create and solve
-// @param[in,out] solution inputs a current solution and returns the projected solution
-// @param[out] stores the new, projected solution found during the algorithm
-int reduce_solve_projection(int *Icompress, double **qubo, int qubo_size, int subMatrix, int8_t *solution,
-                            parameters_t *param) {
-    int change = 0;
-    int8_t *sub_solution = (int8_t *)malloc(sizeof(int8_t) * subMatrix);
-    double **sub_qubo;
-
-    sub_qubo = (double **)malloc2D(qubo_size, qubo_size, sizeof(double));
-
-    reduce(Icompress, qubo, subMatrix, qubo_size, sub_qubo, solution, sub_solution);
+// @param solution the current solution, clamping the variables outside Icompress
+// @param flip_cost the flip costs of solution, or NULL; with them the layouts reduce_flip_cost_layout() accepts
+//      are reduced by reduce_flip_cost(), every other case by qubo_reduce()
+// @param param the sub_sampler and its data used to solve the subMatrix
+// @param work scratch memory for sub QUBOs of at least subMatrix variables
+void reduce_solve(const qbsolv_context_t *ctx, int *Icompress, const qubo_matrix_t *qubo, int subMatrix,
+                  int8_t *solution, const double *flip_cost, parameters_t *param, solver_workspace_t *work) {
+    int8_t *sub_solution = work->sub_solution;
+    double **sub_qubo = work->sub_qubo;
+
+    if (flip_cost != NULL && reduce_flip_cost_layout(qubo)) {
+        reduce_flip_cost(Icompress, qubo, subMatrix, sub_qubo, solution, sub_solution, flip_cost);
+    } else {
+        qubo_reduce(Icompress, qubo, subMatrix, sub_qubo, solution, sub_solution);
+    }
     // solve
-    if (Verbose_ > 3) {
+    if (ctx->verbose > 3) {
         printf("\nBits set before solver ");
         for (int j = 0; j < subMatrix; j++) printf("%d", solution[Icompress[j]]);
     }
@@ -538,46 +1178,92 @@ int reduce_solve_projection(int *Icompress, double **qubo, int qubo_size, int su
         sub_solution[i] = solution[Icompress[i]];
     }
 
-    param->sub_sampler(sub_qubo, subMatrix, sub_solution, param->sub_sampler_data);
+    // once stopped the sub solution is left as it is, so nothing changes
+    if (solve_stopped(ctx)) return;
+
+    if (param->sub_sampler == &tabu_sub_sample) {
+        tabu_sub_solve(ctx, sub_qubo, subMatrix, sub_solution, work);  // same as the callback, without allocating
+    } else {
+        param->sub_sampler(sub_qubo, subMatrix, sub_solution, param->sub_sampler_data);
+    }
 
     // modification to write out subqubos
     // char subqubofile[sizeof "subqubo10000.qubo"];
     // sprintf(subqubofile,"subqubo%05ld.qubo",numPartCalls);
     // write_qubo(sub_qubo,subMatrix,subqubofile);
+}
+
+// project_solution writes the solution of a sub QUBO back into the variables it was extracted from
+//      and returns the number of changes
+// @param ctx the verbosity
+// @param Icompress the variables of the sub QUBO
+// @param subMatrix is the size of the sub QUBO
+// @param sub_solution the solution of the sub QUBO
+// @param[in,out] solution the full solution the sub solution is projected on
+// @param qubo the full QUBO
+// @param[in,out] flip_cost the flip costs of solution, kept up to date by flipping the changed bits
+//      with qubo_evaluate_1bit(), or NULL
+// @param[in,out] energy the energy of solution, kept up to date along with flip_cost
+int project_solution(const qbsolv_context_t *ctx, int *Icompress, int subMatrix, int8_t *sub_solution,
+                     int8_t *solution, const qubo_matrix_t *qubo, double *flip_cost, double *energy) {
+    int change = 0;
 
-    // projection
-    if (Verbose_ > 3) {
+    if (ctx->verbose > 3) {
         printf("\nBits set after solver  ");
         for (int j = 0; j < subMatrix; j++) printf("%d", sub_solution[j]);
         printf("\n");
     }
     for (int j = 0; j < subMatrix; j++) {
         int bit = Icompress[j];
-        if (solution[bit] != sub_solution[j]) change++;
-        solution[bit] = sub_solution[j];
+        if (solution[bit] == sub_solution[j]) continue;
+        change++;
+        if (flip_cost != NULL) {
+            *energy = qubo_evaluate_1bit(*energy, bit, solution, qubo, flip_cost);
+        } else {
+            solution[bit] = sub_solution[j];
+        }
     }
 
-    free(sub_solution);
-    free(sub_qubo);
     return change;
 }
 
+// reduce_solv_projection reduces from a submatrix solves the QUBO projects the solution and
+//      returns the number of changes
+// @param ctx the verbosity and sign of what is printed
+// @param Icompress index vector , ordered lowest to highest, of the row/columns to extract subQubo
+// @param qubo is the QUBO matrix to extract from
+// @param subMatrix is the size of the subMatrix to create and solve
+// @param[in,out] solution inputs a current solution and returns the projected solution
+// @param[out] stores the new, projected solution found during the algorithm
+// @param param the sub_sampler and its data used to solve the subMatrix
+// @param work scratch memory for sub QUBOs of at least subMatrix variables
+int reduce_solve_projection(const qbsolv_context_t *ctx, int *Icompress, const qubo_matrix_t *qubo, int subMatrix,
+                            int8_t *solution, parameters_t *param, solver_workspace_t *work) {
+    reduce_solve(ctx, Icompress, qubo, subMatrix, solution, NULL, param, work);
+    return project_solution(ctx, Icompress, subMatrix, work->sub_solution, solution, qubo, NULL, NULL);
+}
+
 void dw_sub_sample(double **sub_qubo, int subMatrix, int8_t *sub_solution, void *sub_sampler_data) {
     dw_solver(sub_qubo, subMatrix, sub_solution);
     int64_t sub_bit_flips = 0;  //  run a local search with higher precision than the Dwave
     double *flip_cost = (double *)malloc(sizeof(double) * subMatrix);
-    local_search(sub_solution, subMatrix, sub_qubo, flip_cost, &sub_bit_flips);
+    int *order = (int *)malloc(sizeof(int) * subMatrix);
+    qubo_matrix_t matrix = dense_qubo_matrix(sub_qubo, subMatrix);
+    qbsolv_context_t ctx = default_context();  // the callback has no context, so it never stops
+    local_search(&ctx, sub_solution, &matrix, flip_cost, &sub_bit_flips, order);
+    free(order);
     free(flip_cost);
 }
 
-void tabu_sub_sample(double **sub_qubo, int subMatrix, int8_t *sub_solution, void *sub_sampler_data) {
-    int *TabuK;
-    int *index;
-    double *flip_cost = (double *)malloc(sizeof(double) * subMatrix);
-    int8_t *current_best = (int8_t *)malloc(sizeof(int8_t) * subMatrix);
+// Tabu search on a sub QUBO using the sub problem buffers of a workspace, the body of tabu_sub_sample
+void tabu_sub_solve(const qbsolv_context_t *ctx, double **sub_qubo, int subMatrix, int8_t *sub_solution,
+                    solver_workspace_t *work) {
+    if (tabu_sub_solve_fixed(ctx, sub_qubo, subMatrix, sub_solution)) return;
 
-    if (GETMEM(TabuK, int, subMatrix) == NULL) BADMALLOC
-    if (GETMEM(index, int, subMatrix) == NULL) BADMALLOC
+    int *TabuK = work->sub_tabu;
+    int *index = work->sub_index;
+    double *flip_cost = work->sub_flip_cost;
+    int8_t *current_best = work->sub_best;
 
     int64_t bit_flips = 0;
     for (int i = 0; i < subMatrix; i++) {
@@ -585,12 +1271,16 @@ void tabu_sub_sample(double **sub_qubo, int subMatrix, int8_t *sub_solution, voi
         index[i] = i;
         current_best[i] = sub_solution[i];
     }
-    solv_submatrix(sub_solution, current_best, subMatrix, sub_qubo, flip_cost, &bit_flips, TabuK, index);
+    qubo_matrix_t matrix = dense_qubo_matrix(sub_qubo, subMatrix);
+    solv_submatrix(ctx, sub_solution, current_best, &matrix, flip_cost, &bit_flips, TabuK, index, work->sub_order);
+}
 
-    free(current_best);
-    free(flip_cost);
-    free(index);
-    free(TabuK);
+// The callback has no context, so it solves quietly; solve_qubo_context calls tabu_sub_solve with its own
+void tabu_sub_sample(double **sub_qubo, int subMatrix, int8_t *sub_solution, void *sub_sampler_data) {
+    qbsolv_context_t ctx = default_context();
+    solver_workspace_t *work = solver_workspace_create(subMatrix, subMatrix);
+    tabu_sub_solve(&ctx, sub_qubo, subMatrix, sub_solution, work);
+    solver_workspace_free(work);
 }
 
 // Define the default set of parameters for the solve routine
@@ -600,10 +1290,317 @@ parameters_t default_parameters() {
     param.sub_sampler = &tabu_sub_sample;
     param.sub_size = 47;
     param.sub_sampler_data = NULL;
+    param.num_threads = 1;
+    param.independent_groups = false;
+    param.num_islands = 1;
+    param.migration_interval = 4;
+    param.progress = NULL;
+    param.progress_data = NULL;
+    param.initial_solutions = NULL;
+    param.num_initial_solutions = 0;
     return param;
 }
 
-// Entry into the overall solver from the main program
+// Define the default context for the solve routine, the defaults of the command line program
+qbsolv_context_t default_context() {
+    qbsolv_context_t ctx;
+    ctx.verbose = 0;
+    ctx.quiet = false;
+    ctx.find_max = false;
+    strncpy(ctx.algo, "o", sizeof(ctx.algo));
+    ctx.target_set = false;
+    ctx.target = 0.0;
+    ctx.timeout = 2592000;  // a month's worth of seconds
+    ctx.tabu_tenure = -1;
+    ctx.write_matrix = false;
+    ctx.out = stdout;
+    ctx.num_outputs = 0;
+    ctx.seed = 17932241798878;
+    ctx.start = 0.0;          // solve_qubo_context sets it
+    ctx.deadline = HUGE_VAL;  // never, solve_qubo_context sets it from timeout
+    ctx.cancel = NULL;
+    return ctx;
+}
+
+// The sub QUBOs of a submatrix pass solved at the same time, up to width of them a batch.
+// Every sub QUBO of a batch is clamped by the solution as it was before the batch, and the
+// sub solutions are projected back in pass order, so the result does not depend on which
+// thread finishes first.
+typedef struct sub_batch_t {
+    struct thread_pool *pool;
+    int width;
+    int size;  // the largest full QUBO the buffers hold
+    int sub_size;
+    // the sub problem buffers of each sub QUBO of a batch, width entries
+    solver_workspace_t **work;
+    // the random number generator of each sub QUBO of a batch, width entries
+    solver_rng_t *stream;
+    // the variables of every sub QUBO of the pass, sub_size entries apiece
+    int *groups;
+    // the groups of the pass not solved yet, in pass order, and those of the current batch
+    int *pending;
+    int *members;
+    // 1 for the variables of the current batch, when picking independent groups
+    int8_t *mark;
+    // the inputs of the current batch
+    const qubo_matrix_t *qubo;
+    int8_t *solution;
+    double *flip_cost;
+    const qbsolv_context_t *ctx;
+    parameters_t *param;
+} sub_batch_t;
+
+// Start width threads and allocate the buffers to solve up to width sub QUBOs at the same time
+//
+// @param size the number of variables of the full QUBO
+// @param sub_size the number of variables of the sub QUBOs
+// @param width the number of sub QUBOs solved at the same time
+// @returns the batch state, to be released with sub_batch_free
+static sub_batch_t *sub_batch_create(int size, int sub_size, int width) {
+    sub_batch_t *batch;
+    int max_groups = size / sub_size + 1;  // submatrix passes cover at most size variables
+
+    if (GETMEM(batch, sub_batch_t, 1) == NULL) BADMALLOC
+    batch->width = width;
+    batch->size = size;
+    batch->sub_size = sub_size;
+    if (GETMEM(batch->work, solver_workspace_t *, width) == NULL) BADMALLOC
+    for (int i = 0; i < width; i++) batch->work[i] = solver_workspace_create(sub_size, sub_size);
+    if (GETMEM(batch->stream, solver_rng_t, width) == NULL) BADMALLOC
+    if (GETMEM(batch->groups, int, (size_t)max_groups * sub_size) == NULL) BADMALLOC
+    if (GETMEM(batch->pending, int, max_groups) == NULL) BADMALLOC
+    if (GETMEM(batch->members, int, width) == NULL) BADMALLOC
+    if (GETMEM(batch->mark, int8_t, size) == NULL) BADMALLOC
+    for (int i = 0; i < size; i++) batch->mark[i] = 0;
+    batch->pool = thread_pool_create(width);
+    return batch;
+}
+
+// Stop the threads of a batch state created by sub_batch_create and release it
+static void sub_batch_free(sub_batch_t *batch) {
+    if (batch == NULL) return;
+    thread_pool_free(batch->pool);
+    for (int i = 0; i < batch->width; i++) solver_workspace_free(batch->work[i]);
+    free(batch->work);
+    free(batch->stream);
+    free(batch->groups);
+    free(batch->pending);
+    free(batch->members);
+    free(batch->mark);
+    free(batch);
+}
+
+// true if a variable of group is one of, or shares a coupler with one of, the variables of the
+// first num_members groups of the current batch, whose variables are set in mark
+static bool sub_batch_interacts(const sub_batch_t *batch, const int *group, int num_members) {
+    const qubo_matrix_t *qubo = batch->qubo;
+    const int sub_size = batch->sub_size;
+
+    for (int i = 0; i < sub_size; i++) {
+        if (batch->mark[group[i]]) return true;
+    }
+    if (qubo->layout == QUBO_SPARSE) {
+        const sparse_qubo_t *sparse = qubo->sparse;
+        for (int i = 0; i < sub_size; i++) {
+            for (int64_t k = sparse->row_start[group[i]]; k < sparse->row_start[group[i] + 1]; k++) {
+                if (batch->mark[sparse->columns[k]] && sparse->values[k] != 0.0) return true;
+            }
+        }
+        return false;
+    }
+    // every dense layout keeps the couplers in the upper triangle of dense
+    for (int m = 0; m < num_members; m++) {
+        const int *other = batch->groups + (size_t)batch->members[m] * sub_size;
+        for (int i = 0; i < sub_size; i++) {
+            for (int j = 0; j < sub_size; j++) {
+                int row = MIN(group[i], other[j]), col = MAX(group[i], other[j]);
+                if (qubo->dense[row][col] != 0.0) return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Solve sub QUBO task of the current batch into its workspace, on a pool thread
+static void sub_batch_task(void *data, int task) {
+    sub_batch_t *batch = (sub_batch_t *)data;
+    int *group = batch->groups + (size_t)batch->members[task] * batch->sub_size;
+
+    // the calling thread of thread_pool_run runs tasks too, its generator is the solve's
+    solver_rng_t *solve_rng = solver_rand_stream(&batch->stream[task]);
+    reduce_solve(batch->ctx, group, batch->qubo, batch->sub_size, batch->solution, batch->flip_cost, batch->param,
+                 batch->work[task]);
+    solver_rand_stream(solve_rng);
+}
+
+// Solve the num_groups sub QUBOs filled into batch->groups a batch at a time and project their
+// solutions back
+//
+// Each batch takes the first width groups not solved yet; with param->independent_groups a
+// group that is coupled to one already in the batch waits for a later batch, so that the
+// clamped values every sub QUBO of the batch was reduced with are still the ones around it
+// after the merge.
+//
+// @param ctx the context of the solve, read by every thread
+// @param batch the threads and buffers, with groups filled
+// @param num_groups the number of sub QUBOs of the pass
+// @param qubo the full QUBO
+// @param[in,out] solution the current solution, updated with every sub solution
+// @param[in,out] flip_cost the flip costs of solution to reduce from and keep up to date, or NULL
+// @param[in,out] energy the energy of solution, kept up to date along with flip_cost
+// @param param the sub_sampler and its data, and independent_groups
+// @returns the number of bits changed
+static int sub_batch_pass(const qbsolv_context_t *ctx, sub_batch_t *batch, int num_groups, const qubo_matrix_t *qubo,
+                          int8_t *solution, double *flip_cost, double *energy, parameters_t *param) {
+    const int sub_size = batch->sub_size;
+    int change = 0;
+    int num_pending = num_groups;
+
+    batch->qubo = qubo;
+    batch->solution = solution;
+    batch->flip_cost = flip_cost;
+    batch->ctx = ctx;
+    batch->param = param;
+    for (int g = 0; g < num_groups; g++) batch->pending[g] = g;
+
+    while (num_pending > 0) {
+        int num_members = 0, num_kept = 0;
+        for (int p = 0; p < num_pending; p++) {
+            int g = batch->pending[p];
+            int *group = batch->groups + (size_t)g * sub_size;
+            if (num_members < batch->width &&
+                (!param->independent_groups || !sub_batch_interacts(batch, group, num_members))) {
+                batch->members[num_members++] = g;
+                if (param->independent_groups) {
+                    for (int i = 0; i < sub_size; i++) batch->mark[group[i]] = 1;
+                }
+            } else {
+                batch->pending[num_kept++] = g;
+            }
+        }
+        num_pending = num_kept;
+
+        // the seeds are drawn in pass order, before any thread runs
+        for (int m = 0; m < num_members; m++) {
+            solver_rng_seed(&batch->stream[m], solver_rand64());
+        }
+        thread_pool_run(batch->pool, num_members, sub_batch_task, batch);
+
+        for (int m = 0; m < num_members; m++) {
+            int *group = batch->groups + (size_t)batch->members[m] * sub_size;
+            change += project_solution(ctx, group, sub_size, batch->work[m]->sub_solution, solution, qubo, flip_cost,
+                                       energy);
+            for (int i = 0; i < sub_size; i++) batch->mark[group[i]] = 0;
+        }
+    }
+    return change;
+}
+
+// Pass a better solution to param->progress, if there is one
+//
+// @param ctx the sign of the energy, and the deadline the start of the solve is found from
+// @param param the callback and its data
+// @param solution, qubo_size, energy the solution, its size and its energy as the solver keeps it
+// @param bit_flips, numPartCalls the work done so far
+// @return false when the callback asks the solve to stop
+static bool report_progress(const qbsolv_context_t *ctx, parameters_t *param, const int8_t *solution, int qubo_size,
+                            double energy, int64_t bit_flips, long numPartCalls) {
+    if (param->progress == NULL) return true;
+    double sign = ctx->find_max ? 1.0 : -1.0;
+    return param->progress(solution, qubo_size, energy * sign, solve_seconds(ctx), bit_flips, numPartCalls,
+                           param->progress_data);
+}
+
+// The solution tables the islands of solve_islands share, and what they report to the solve
+typedef struct island_exchange_t {
+    std::mutex lock;  // held for every use of the tables, ctx and numPartCalls
+    qbsolv_context_t *ctx;
+    const qubo_matrix_t *qubo;
+    parameters_t *param;
+    int8_t **solution_list;
+    double *energy_list;
+    int *solution_counts;
+    int *Qindex;
+    int QLEN;
+    int num_nq_solutions;
+    struct solution_pool *pool;
+    long numPartCalls;       // the sub QUBOs the islands have reported solving
+    std::atomic<bool> stop;  // an island reached the target, the others stop after their pass
+    uint64_t *seeds;         // of the generator of each island, drawn before any island starts
+} island_exchange_t;
+
+// Add a solution of an island to the shared tables, printing it when it is the best so far
+//
+// @param exchange the shared tables
+// @param solution the solution, or NULL to only report new_calls
+// @param energy the energy of solution
+// @param new_calls the sub QUBOs the island solved since it last reported
+// @param bit_flips the bit flips of the island so far, for the progress callback
+static void island_publish(island_exchange_t *exchange, int8_t *solution, double energy, long new_calls,
+                           int64_t bit_flips) {
+    const int qubo_size = exchange->qubo->size;
+    qbsolv_context_t *ctx = exchange->ctx;
+    std::lock_guard<std::mutex> guard(exchange->lock);
+
+    exchange->numPartCalls += new_calls;
+    if (solution == NULL) return;
+    struct sol_man_rslt result =
+        manage_solutions(ctx, solution, exchange->solution_list, energy, exchange->energy_list,
+                         exchange->solution_counts, exchange->Qindex, exchange->QLEN, qubo_size,
+                         &exchange->num_nq_solutions, exchange->pool);
+    if (result.code != NEW_HIGH_ENERGY_UNIQUE_SOL) return;
+    if (ctx->verbose > 0) {
+        double sign = ctx->find_max ? 1.0 : -1.0;
+        print_output(ctx, qubo_size, solution, exchange->numPartCalls, energy * sign, solve_seconds(ctx),
+                     exchange->param);
+    }
+    if (!report_progress(ctx, exchange->param, solution, qubo_size, energy, bit_flips, exchange->numPartCalls)) {
+        exchange->stop = true;
+    }
+}
+
+// Add the best shared solution to the solution tables of an island when it is better than any
+// the island has found
+//
+// @param exchange the shared tables
+// @param ctx the context of the island
+// @param[in,out] solution_list .. pool the solution tables of the island, as for manage_solutions
+static void island_import(island_exchange_t *exchange, const qbsolv_context_t *ctx, int8_t **solution_list,
+                          double *energy_list, int *solution_counts, int *Qindex, int QLEN, int *num_nq_solutions,
+                          struct solution_pool *pool) {
+    std::lock_guard<std::mutex> guard(exchange->lock);
+
+    if (exchange->num_nq_solutions == 0) return;
+    int best = exchange->Qindex[0];
+    if (exchange->energy_list[best] > energy_list[Qindex[0]]) {
+        manage_solutions(ctx, exchange->solution_list[best], solution_list, exchange->energy_list[best], energy_list,
+                         solution_counts, Qindex, QLEN, exchange->qubo->size, num_nq_solutions, pool);
+    }
+}
+
+// Pick the solution an island restarts from: one of the shared solutions at random, with the bits
+// the shared solutions do not all agree on randomized, or a random solution while fewer than two
+// have been shared
+//
+// @param exchange the shared tables
+// @param[out] solution the solution to restart from
+// @param scratch room for exchange->qubo->size ints
+static void island_restart(island_exchange_t *exchange, int8_t *solution, int *scratch) {
+    const int qubo_size = exchange->qubo->size;
+    std::lock_guard<std::mutex> guard(exchange->lock);
+
+    int num_solutions = exchange->num_nq_solutions;
+    if (num_solutions < 2) {
+        randomize_solution(solution, qubo_size);
+        return;
+    }
+    int pick = exchange->Qindex[solver_rand_below(num_solutions)];
+    for (int i = 0; i < qubo_size; i++) solution[i] = exchange->solution_list[pick][i];
+    int len_index = pool_index_solution_diff(exchange->pool, num_solutions, scratch, 0, exchange->Qindex);
+    randomize_solution_by_index(solution, len_index, scratch);
+}
+
+// The outer loop of the solver, on its own or as one island of solve_islands
 //
 // It is the main function for solving a quadratic boolean optimization problem.
 //
@@ -619,38 +1616,48 @@ parameters_t default_parameters() {
 // is chosen based on randomizing those variables.
 //
 // After Pchk = 8 iterations with no improvement, the algorithm is
-//   completely restarted with a new random solution.
+//   completely restarted with a new random solution, or as an island from the shared solutions.
 // After nRepeats iterations with no improvement, the algorithm terminates.
 //
-// @param qubo The QUBO matrix to be solved
-// @param qubo_size is the number of variables in the QUBO matrix
+// @param[in,out] ctx the options of the run and its output state
+// @param qubo The QUBO matrix to be solved, in any of the supported layouts
 // @param[out] solution_list output solution table
 // @param[out] energy_list output energy table
 // @param[out] solution_counts output occurence table
 // @param[out] Qindex order of entries in the solution table
 // @param QLEN Number of entries in the solution table
 // @param[in,out] param Other parameters to the solve method that have default values.
-void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *energy_list, int *solution_counts,
-           int *Qindex, int QLEN, parameters_t *param) {
+// @param[in,out] exchange the tables shared with the other islands, or NULL when solving alone
+// @param resume NULL, or the state of the last solve, whose tables are the ones passed in: the
+//      initial search is then a regular tabu pass from its solution and flip costs
+// @param[in,out] reuse NULL, or a workspace of at least qubo->size variables in sub QUBOs of
+//      param->sub_size to solve in and keep for the next solve
+// @return the number of sub QUBOs solved
+static long solve_island(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list,
+                         double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param,
+                         island_exchange_t *exchange, const qbsolv_state_t *resume, solver_workspace_t *reuse) {
+    const int qubo_size = qubo->size;
     double *flip_cost, energy;
-    int *TabuK, *index, start_;
+    int *TabuK, *index;
     int8_t *solution, *tabu_solution;
     long numPartCalls = 0;
     int64_t bit_flips = 0, IterMax;
 
-    start_ = clock();
     bit_flips = 0;
 
-    // Get some memory for the larger val matrix to solve
-    if (GETMEM(solution, int8_t, qubo_size) == NULL) BADMALLOC
-    if (GETMEM(tabu_solution, int8_t, qubo_size) == NULL) BADMALLOC
-    if (GETMEM(flip_cost, double, qubo_size) == NULL) BADMALLOC
-    if (GETMEM(index, int, qubo_size) == NULL) BADMALLOC
-    if (GETMEM(TabuK, int, qubo_size) == NULL) BADMALLOC
+    // the scratch memory of the solve, the caller's when it solves QUBO after QUBO
+    const int subMatrix = param->sub_size;
+    solver_workspace_t *work = reuse != NULL ? reuse : solver_workspace_create(qubo_size, subMatrix);
+    workspace_outer_create(work, QLEN + 1);
+    solution = work->solution;
+    tabu_solution = work->tabu_solution;
+    flip_cost = work->flip_cost;
+    index = work->index;
+    TabuK = work->tabu;
 
     int num_nq_solutions = 0;
 
-    for (int i = 0; i < QLEN + 1; i++) {
+    for (int i = 0; i < QLEN + 1 && resume == NULL; i++) {
         energy_list[i] = BIGNEGFP;
         solution_counts[i] = 0;
         for (int j = 0; j < qubo_size; j++) {
@@ -664,15 +1671,46 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
     double best_energy;
     int *Pcompress;
 
-    if (GETMEM(Pcompress, int, qubo_size) == NULL) BADMALLOC
+    Pcompress = work->pcompress;
+    // bit-packed copies of the solution_list entries, for duplicate checks and the "d" backbone
+    struct solution_pool *pool = work->pool;
+    solution_pool_reset(pool, QLEN + 1, qubo_size);
+    // a resumed solve goes on with the solutions of the last one, their energies kept up to date
+    if (resume != NULL) {
+        val_index_sort_ns(Qindex, energy_list, QLEN);
+        while (num_nq_solutions < QLEN && energy_list[Qindex[num_nq_solutions]] != BIGNEGFP) {
+            int row = Qindex[num_nq_solutions++];
+            solution_pool_store(pool, row, solution_list[row]);
+        }
+    }
     // initialize and set some tuning parameters
     //
     const int Progress_check = 12;                // number of non-progresive passes thru main loop before reset
     const float SubMatrix_span = 0.214f;          // percent of the total size will be covered by the subMatrix pass
     const int64_t InitialTabuPass_factor = 6500;  // initial pass factor for tabu iterations
     const int64_t TabuPass_factor = 1700;         // iterative pass factor for tabu iterations
-
-    const int subMatrix = param->sub_size;
+    const int Drift_check = 8;                    // outer loop passes between full evaluations of flip_cost
+
+    // a sparse bit flip changes few flip costs, so the full tabu passes keep them in a move tree
+    struct move_tree *tree = NULL;
+    if (qubo->layout == QUBO_SPARSE) {
+        if (work->tree == NULL || work->tree->size != qubo_size) {
+            move_tree_free(work->tree);
+            work->tree = move_tree_create(qubo_size);
+        }
+        tree = work->tree;
+    }
+    // the sub QUBOs of the submatrix passes are solved param->num_threads at a time, by threads
+    // kept in the workspace
+    sub_batch_t *batch = NULL;
+    if (param->num_threads > 1 && subMatrix < qubo_size) {
+        if (work->batch == NULL || work->batch->width != param->num_threads || work->batch->size < qubo_size ||
+            work->batch->sub_size != subMatrix) {
+            sub_batch_free(work->batch);
+            work->batch = sub_batch_create(qubo_size, subMatrix, param->num_threads);
+        }
+        batch = work->batch;
+    }
     int MaxNodes_sub = MAX(subMatrix + 1, SubMatrix_span * qubo_size);
     int l_max = MIN(qubo_size - subMatrix, MaxNodes_sub);
     int len_index = 0;
@@ -684,70 +1722,112 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
     }
 
     int l = 0, DwaveQubo = 0;
-    double sign = findMax_ ? 1.0 : -1.0;
+    bool flip_cost_valid = false;  // flip_cost is that of solution, as every tabu_search leaves it
+    // the bit flips of every layout but QUBO_FLOAT are exact enough to carry flip_cost and energy
+    // from one tabu_search through the submatrix passes to the next
+    const bool keep_flip_cost = qubo->layout != QUBO_FLOAT;
+    int passes_since_resync = 0;
+    int passes_since_migration = 0;
+    double shared_energy = BIGNEGFP;  // the best energy the island has published
+    long shared_calls = 0;            // the sub QUBOs the island has reported
+    double sign = ctx->find_max ? 1.0 : -1.0;
     struct sol_man_rslt result;
 
+    // warm start, the initial search starts from the best of the initial solutions
+    if (param->num_initial_solutions > 0 && resume == NULL) {
+        for (int k = 0; k < param->num_initial_solutions; k++) {
+            for (int i = 0; i < qubo_size; i++) solution[i] = param->initial_solutions[k][i];
+            energy = qubo_evaluate(solution, qubo, flip_cost);
+            manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                             qubo_size, &num_nq_solutions, pool);
+        }
+        for (int i = 0; i < qubo_size; i++) solution[i] = solution_list[Qindex[0]][i];
+    }
+
     // run initial Searches to prime the solutions for outer loop based upon algorithm choice
     //
-    if (strncmp(&algo_[0], "o", strlen("o")) == 0) {
+    if (resume != NULL) {
+        // a regular pass from where the last solve ended, the solution tables are primed already
+        for (int i = 0; i < qubo_size; i++) {
+            solution[i] = resume->solution[i];
+            flip_cost[i] = resume->flip_cost[i];
+        }
+        energy = resume->energy;
+        IterMax = bit_flips + TabuPass_factor * (int64_t)qubo_size;
+        energy = tabu_search(ctx, solution, tabu_solution, qubo, flip_cost, &bit_flips, IterMax, TabuK, ctx->target,
+                             ctx->target_set, index, 0, work->order, tree, keep_flip_cost ? &energy : NULL);
+        flip_cost_valid = true;
+        result = manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                                  qubo_size, &num_nq_solutions, pool);
+        Qbest = &solution_list[Qindex[0]][0];
+        best_energy = energy_list[Qindex[0]];
+
+    } else if (strncmp(&ctx->algo[0], "o", strlen("o")) == 0) {
         IterMax = bit_flips + (int64_t)MAX((int64_t)400, InitialTabuPass_factor * (int64_t)qubo_size);
-        if (Verbose_ > 2) {
-            DLT;
+        if (ctx->verbose > 2) {
+            printf("%lf seconds ", solve_seconds(ctx));
             printf(" Starting Full initial Tabu\n");
         }
-        energy = tabu_search(solution, tabu_solution, qubo_size, qubo, flip_cost, &bit_flips, IterMax, TabuK, Target_,
-                             TargetSet_, index, 0);
+        energy = tabu_search(ctx, solution, tabu_solution, qubo, flip_cost, &bit_flips, IterMax, TabuK, ctx->target,
+                             ctx->target_set, index, 0, work->order, tree, NULL);
+        flip_cost_valid = true;
 
         // save best result
         best_energy = energy;
-        result = manage_solutions(solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
-                                  qubo_size, &num_nq_solutions);
+        result = manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                                  qubo_size, &num_nq_solutions, pool);
         Qbest = &solution_list[Qindex[0]][0];
 
-    } else if (strncmp(&algo_[0], "d", strlen("d")) == 0) {
+    } else if (strncmp(&ctx->algo[0], "d", strlen("d")) == 0) {
         // when using this method we need at least solutions for a "differential" backbone this
         // step is to prime the solution sets with at least one more
         //
         len_index = 0;
         int pass = 0;
-        while (len_index < MIN(1 * subMatrix, qubo_size / 2)) {
+        while (len_index < MIN(1 * subMatrix, qubo_size / 2) && !solve_stopped(ctx)) {
             // DL;printf(" len_index %d %d \n",len_index,pass);
             randomize_solution(solution, qubo_size);
-            energy = local_search(solution, qubo_size, qubo, flip_cost, &bit_flips);
-            result = manage_solutions(solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
-                                      qubo_size, &num_nq_solutions);
-            len_index = mul_index_solution_diff(solution_list, num_nq_solutions, qubo_size, Pcompress, 0, Qindex);
+            energy = local_search(ctx, solution, qubo, flip_cost, &bit_flips, work->order);
+            result = manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                                      qubo_size, &num_nq_solutions, pool);
+            len_index = pool_index_solution_diff(pool, num_nq_solutions, Pcompress, 0, Qindex);
             if (pass++ > 40) break;
             // printf(" len_index = %d  NU %d  energy %lf\n",len_index,NU,energy);
         }
         solution_population(solution, solution_list, num_nq_solutions, qubo_size, Qindex, 10);
         IterMax = bit_flips + (int64_t)MAX((int64_t)40, InitialTabuPass_factor * (int64_t)qubo_size / 2);
-        energy = tabu_search(solution, tabu_solution, qubo_size, qubo, flip_cost, &bit_flips, IterMax, TabuK, Target_,
-                             TargetSet_, index, 0);
-        result = manage_solutions(solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
-                                  qubo_size, &num_nq_solutions);
+        energy = tabu_search(ctx, solution, tabu_solution, qubo, flip_cost, &bit_flips, IterMax, TabuK, ctx->target,
+                             ctx->target_set, index, 0, work->order, tree, NULL);
+        flip_cost_valid = true;
+        result = manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                                  qubo_size, &num_nq_solutions, pool);
         Qbest = &solution_list[Qindex[0]][0];
         best_energy = energy_list[Qindex[0]];
 
     } else {
-        fprintf(stderr, "Did not recognize algorithm %s\n", algo_);
+        fprintf(stderr, "Did not recognize algorithm %s\n", ctx->algo);
         exit(2);
     }
 
     val_index_sort(index, flip_cost, qubo_size);  // create index array of sorted values
-    if (Verbose_ > 0) {
-        print_output(qubo_size, solution, numPartCalls, best_energy * sign, CPSECONDS, param);
+    if (ctx->verbose > 0) {
+        print_output(ctx, qubo_size, solution, numPartCalls, best_energy * sign, solve_seconds(ctx), param);
     }
-    if (Verbose_ > 1) {
-        DLT;
+    // islands report what they share instead
+    bool stop_requested = false;
+    if (exchange == NULL) {
+        stop_requested = !report_progress(ctx, param, Qbest, qubo_size, best_energy, bit_flips, numPartCalls);
+    }
+    if (ctx->verbose > 1) {
+        printf("%lf seconds ", solve_seconds(ctx));
         printf(" V Starting outer loop =%lf iterations %" LONGFORMAT "\n", best_energy * sign, bit_flips);
     }
 
     // starting main search loop Partition ( run parts on tabu or Dwave ) --> Tabu rinse and repeat
     short RepeatPass = 0, NoProgress = 0;
     short ContinueWhile = false;
-    if (TargetSet_) {
-        if (best_energy >= (sign * Target_)) {
+    if (ctx->target_set) {
+        if (best_energy >= (sign * ctx->target)) {
             ContinueWhile = false;
         } else {
             ContinueWhile = true;
@@ -759,6 +1839,7 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
             ContinueWhile = false;
         }
     }
+    if (stop_requested) ContinueWhile = false;
 
     DwaveQubo = 0;
 
@@ -766,18 +1847,18 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
     while (ContinueWhile) {
         if (qubo_size > 20 &&
             subMatrix < qubo_size) {  // these are of the size that will use updates from submatrix processing
-            if (strncmp(&algo_[0], "o", strlen("o")) == 0) {
+            if (strncmp(&ctx->algo[0], "o", strlen("o")) == 0) {
                 // use the first "remove" index values to remove rows and columns from new matrix
                 // initial TabuK to nothing tabu sub_solution[i] = Q[i];
                 // create compression bit vector
                 val_index_sort(index, flip_cost, qubo_size);  // Create index array of sorted values
                 l_max = MIN(qubo_size - subMatrix, MaxNodes_sub);
-                if (Verbose_ > 1)
+                if (ctx->verbose > 1)
                     printf("Reduced submatrix solution l = 0; %d, subMatrix size = %d\n", l_max, subMatrix);
-            } else if (strncmp(&algo_[0], "d", strlen("d")) == 0) {
+            } else if (strncmp(&ctx->algo[0], "d", strlen("d")) == 0) {
                 // pick "backbone" as an index of non-matching bits in solutions
                 //
-                len_index = mul_index_solution_diff(solution_list, num_nq_solutions, qubo_size, Pcompress, 0, Qindex);
+                len_index = pool_index_solution_diff(pool, num_nq_solutions, Pcompress, 0, Qindex);
                 // need to cover all of len_index so we will pad out the Qindex to a multiple of subMatrix
                 l_max = len_index;
             }
@@ -787,9 +1868,14 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
                 (Progress_check - 1)) {  // every Progress_check (th) loop without progess
                 // reset completely
                 // solution_population( solution, solution_list, num_nq_solutions, qubo_size, Qindex);
-                randomize_solution(solution, qubo_size);
-                if (Verbose_ > 1) {
-                    DLT;
+                if (exchange != NULL) {
+                    island_restart(exchange, solution, Pcompress);  // Pcompress is refilled next pass
+                } else {
+                    randomize_solution(solution, qubo_size);
+                }
+                flip_cost_valid = false;
+                if (ctx->verbose > 1) {
+                    printf("%lf seconds ", solve_seconds(ctx));
                     printf(" \n\n Reset Q and start over Repeat = %d/%d, as no progress is exhausted %d %d\n\n\n",
                            param->repeats, RepeatPass, NoProgress, NoProgress % Progress_check);
                 }
@@ -797,11 +1883,16 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
                 int change = 0;
                 {  // scope of parallel region
                     int t_change = 0;
-                    int *Icompress;
-                    if (GETMEM(Icompress, int, qubo_size) == NULL) BADMALLOC
+                    int num_groups = 0;
+                    // while flip_cost matches solution the sub QUBOs are reduced from it, and the
+                    // projected bits are flipped through qubo_evaluate_1bit to keep it and energy matching
+                    double *pass_flip_cost = flip_cost_valid && keep_flip_cost ? flip_cost : NULL;
                     for (l = 0; l < l_max; l += subMatrix) {
-                        if (strncmp(&algo_[0], "o", strlen("o")) == 0) {
-                            if (Verbose_ > 3) printf("Submatrix starting at backbone %d\n", l);
+                        // with a batch, collect every group of the pass and solve them below
+                        int *Icompress = work->compress;
+                        if (batch != NULL) Icompress = batch->groups + (size_t)num_groups++ * subMatrix;
+                        if (strncmp(&ctx->algo[0], "o", strlen("o")) == 0) {
+                            if (ctx->verbose > 3) printf("Submatrix starting at backbone %d\n", l);
 
                             for (int i = l, j = 0; i < l + subMatrix; i++) {
                                 Icompress[j++] = index[i];  // create compression index
@@ -809,8 +1900,8 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
                             index_sort(Icompress, subMatrix, true);  // sort it for effective reduction
 
                             // coarsen and reduce the problem
-                        } else if (strncmp(&algo_[0], "d", strlen("d")) == 0) {
-                            if (Verbose_ > 3) printf("Submatrix starting at backbone %d\n", l);
+                        } else if (strncmp(&ctx->algo[0], "d", strlen("d")) == 0) {
+                            if (ctx->verbose > 3) printf("Submatrix starting at backbone %d\n", l);
                             int i_strt = l;
                             if (l + subMatrix > len_index)
                                 i_strt = len_index - subMatrix - 1;  // cover all of len_index by backup on last pass
@@ -818,60 +1909,82 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
                                 Icompress[j++] = Pcompress[i];  // create compression index
                             }
                         }
-                        t_change = reduce_solve_projection(Icompress, qubo, qubo_size, subMatrix, solution, param);
-                        // do the following in a critical region
+                        if (batch != NULL) continue;
+                        reduce_solve(ctx, Icompress, qubo, subMatrix, solution, pass_flip_cost, param, work);
+                        t_change = project_solution(ctx, Icompress, subMatrix, work->sub_solution, solution, qubo,
+                                                    pass_flip_cost, &energy);
 
                         change = change + t_change;
                         numPartCalls++;
                         DwaveQubo++;
-                        // end critical region
                     }
-                    free(Icompress);
+                    if (batch != NULL) {
+                        change = sub_batch_pass(ctx, batch, num_groups, qubo, solution, pass_flip_cost, &energy, param);
+                        numPartCalls += num_groups;
+                        DwaveQubo += num_groups;
+                    }
                 }
 
                 // submatrix search did not produce enough new values, so randomize those bits
                 if (change <= 2) {
-                    if (strncmp(&algo_[0], "o", strlen("o")) == 0) {
+                    flip_cost_valid = false;
+                    if (strncmp(&ctx->algo[0], "o", strlen("o")) == 0) {
                         flip_solution_by_index(solution, l, index);
                         // randomize_solution_by_index(solution, l, index);
-                    } else if (strncmp(&algo_[0], "d", strlen("d")) == 0) {
-                        len_index = mul_index_solution_diff(solution_list, num_nq_solutions, qubo_size, Pcompress, 0,
-                                                            Qindex);
+                    } else if (strncmp(&ctx->algo[0], "d", strlen("d")) == 0) {
+                        len_index = pool_index_solution_diff(pool, num_nq_solutions, Pcompress, 0, Qindex);
                         flip_solution_by_index(solution, len_index, Pcompress);
                         // randomize_solution_by_index(solution, len_index, Pcompress);
                     }
-                    if (Verbose_ > 3) {
+                    if (ctx->verbose > 3) {
                         printf(" Submatrix search did not produce enough new values, so randomize %d bits\n", l);
                     }
                 } else {
-                    if (Verbose_ > 3) {
+                    if (ctx->verbose > 3) {
                         printf("Number of solution Bits changed %d \n ", change);
                     }
                 }
 
                 // completed submatrix passes
-                if (Verbose_ > 1) printf("\n");
+                if (ctx->verbose > 1) printf("\n");
             }
         }
-        if (Verbose_ > 1) {
-            DLT;
+        if (ctx->verbose > 1) {
+            printf("%lf seconds ", solve_seconds(ctx));
             printf(" ***Full Tabu  -- after partition pass \n");
         }
         // FULL TABU run here
 
         IterMax = bit_flips + TabuPass_factor * (int64_t)qubo_size;
         val_index_sort(index, flip_cost, qubo_size);  // Create index array of sorted values
-        energy = tabu_search(solution, tabu_solution, qubo_size, qubo, flip_cost, &bit_flips, IterMax, TabuK, Target_,
-                             TargetSet_, index, 0);
+
+        // start from the flip costs carried through the submatrix passes, resyncing them with a
+        // full evaluation every Drift_check passes so that rounding cannot pile up
+        const double *start_energy = NULL;
+        if (flip_cost_valid && keep_flip_cost) {
+            if (++passes_since_resync >= Drift_check) {
+                double exact = qubo_evaluate(solution, qubo, flip_cost);
+                if (ctx->verbose > 2) {
+                    printf("%lf seconds ", solve_seconds(ctx));
+                    printf(" flip_cost resync, energy drift %g\n", (exact - energy) * sign);
+                }
+                energy = exact;
+                passes_since_resync = 0;
+            }
+            start_energy = &energy;
+        }
+        energy = tabu_search(ctx, solution, tabu_solution, qubo, flip_cost, &bit_flips, IterMax, TabuK, ctx->target,
+                             ctx->target_set, index, 0, work->order, tree, start_energy);
+        flip_cost_valid = true;
         val_index_sort(index, flip_cost, qubo_size);  // Create index array of sorted values
 
-        if (Verbose_ > 1) {
-            DLT;
+        if (ctx->verbose > 1) {
+            printf("%lf seconds ", solve_seconds(ctx));
             printf("Latest answer  %4.5f iterations =%" LONGFORMAT "\n", energy * sign, (int64_t)bit_flips);
         }
 
-        result = manage_solutions(solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
-                                  qubo_size, &num_nq_solutions);
+        result = manage_solutions(ctx, solution, solution_list, energy, energy_list, solution_counts, Qindex, QLEN,
+                                  qubo_size, &num_nq_solutions, pool);
         Qbest = &solution_list[Qindex[0]][0];
         best_energy = energy_list[Qindex[0]];
 
@@ -879,43 +1992,61 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
         if (result.code == NEW_HIGH_ENERGY_UNIQUE_SOL) {  // better solution
             RepeatPass = 0;
 
-            if (Verbose_ > 1) {
-                DLT;
+            if (ctx->verbose > 1) {
+                printf("%lf seconds ", solve_seconds(ctx));
                 printf(" IMPROVEMENT; RepeatPass set to %d\n", RepeatPass);
             }
-            if (Verbose_ > 0) {
-                print_output(qubo_size, Qbest, numPartCalls, best_energy * sign, CPSECONDS, param);
+            if (ctx->verbose > 0) {
+                print_output(ctx, qubo_size, Qbest, numPartCalls, best_energy * sign, solve_seconds(ctx), param);
+            }
+            if (exchange == NULL &&
+                !report_progress(ctx, param, Qbest, qubo_size, best_energy, bit_flips, numPartCalls)) {
+                stop_requested = true;
             }
         } else if (result.code == DUPLICATE_ENERGY ||
                    result.code == DUPLICATE_HIGHEST_ENERGY) {  // equal solution, but it is different
             if (result.pos > 4 || result.count > 8) {
                 randomize_solution(solution, qubo_size);
+                flip_cost_valid = false;
             }
             RepeatPass++;
             if (result.code == DUPLICATE_ENERGY) {
                 NoProgress++;
             }
             if (result.code == DUPLICATE_HIGHEST_ENERGY && result.count == 1) {
-                if (Verbose_ > 0) {
-                    print_output(qubo_size, Qbest, numPartCalls, best_energy * sign, CPSECONDS, param);
+                if (ctx->verbose > 0) {
+                    print_output(ctx, qubo_size, Qbest, numPartCalls, best_energy * sign, solve_seconds(ctx), param);
                 }
             }
         } else if (result.code == NOTHING) {  // not as good as our worst so far
             RepeatPass++;
             NoProgress++;
-            if (Verbose_ > 1) {
+            if (ctx->verbose > 1) {
                 printf("NO improvement RepeatPass =%d\n", RepeatPass);
             }
         }
 
-        if (Verbose_ > 1) {
-            DLT;
+        // trade best solutions with the other islands
+        if (exchange != NULL && ++passes_since_migration >= param->migration_interval) {
+            island_publish(exchange, best_energy > shared_energy ? Qbest : NULL, best_energy,
+                           numPartCalls - shared_calls, bit_flips);
+            shared_energy = MAX(shared_energy, best_energy);
+            shared_calls = numPartCalls;
+            island_import(exchange, ctx, solution_list, energy_list, solution_counts, Qindex, QLEN,
+                          &num_nq_solutions, pool);
+            Qbest = &solution_list[Qindex[0]][0];
+            best_energy = energy_list[Qindex[0]];
+            passes_since_migration = 0;
+        }
+
+        if (ctx->verbose > 1) {
+            printf("%lf seconds ", solve_seconds(ctx));
             printf("V Best outer loop =%lf iterations %" LONGFORMAT "\n", best_energy * sign, bit_flips);
         }
 
         // check on, if to continue the outer loop
-        if (TargetSet_) {
-            if (best_energy >= (sign * Target_)) {
+        if (ctx->target_set) {
+            if (best_energy >= (sign * ctx->target)) {
                 ContinueWhile = false;
             } else {
                 ContinueWhile = true;
@@ -928,31 +2059,474 @@ void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *e
             }
         }
 
-        // timeout test
-        if (CPSECONDS >= Time_) {
+        // an island reaching the target stops them all
+        if (exchange != NULL) {
+            if (ctx->target_set && !ContinueWhile) exchange->stop = true;
+            if (exchange->stop) ContinueWhile = false;
+        }
+
+        // timeout and cancellation test
+        if (solve_stopped(ctx)) {
             ContinueWhile = false;
         }
+        if (stop_requested) ContinueWhile = false;
     }  // end of outer loop
 
-    // all done print results if needed and free allocated arrays
-    if (WriteMatrix_) print_solution_and_qubo(Qbest, qubo_size, qubo);
+    // hand every solution of the island to the shared tables
+    if (exchange != NULL) {
+        island_publish(exchange, NULL, 0.0, numPartCalls - shared_calls, bit_flips);
+        for (int i = 0; i < num_nq_solutions; i++) {
+            if (i == 0 && energy_list[Qindex[0]] <= shared_energy) continue;  // published already
+            island_publish(exchange, solution_list[Qindex[i]], energy_list[Qindex[i]], 0, bit_flips);
+        }
+    }
 
-    if (Verbose_ == 0) {
-        Qbest = &solution_list[Qindex[0]][0];
-        best_energy = energy_list[Qindex[0]];
+    if (reuse == NULL) solver_workspace_free(work);
+
+    return numPartCalls;
+}
+
+// An island of solve_islands, solving into solution tables of its own
+static void island_task(void *data, int task) {
+    island_exchange_t *exchange = (island_exchange_t *)data;
+    const int qubo_size = exchange->qubo->size, QLEN = exchange->QLEN;
+    int8_t **solution_list;
+    double *energy_list;
+    int *solution_counts, *Qindex;
+
+    // the islands print nothing themselves, the shared solutions are printed as they improve
+    qbsolv_context_t ctx;
+    {
+        std::lock_guard<std::mutex> guard(exchange->lock);
+        ctx = *exchange->ctx;
+    }
+    ctx.verbose = 0;
+
+    solution_list = (int8_t **)malloc2D(QLEN + 1, qubo_size, sizeof(int8_t));
+    if (GETMEM(energy_list, double, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(solution_counts, int, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(Qindex, int, QLEN + 1) == NULL) BADMALLOC
+
+    // the calling thread of thread_pool_run runs an island too, its generator is the solve's
+    solver_rng_t rng;
+    solver_rng_seed(&rng, exchange->seeds[task]);
+    solver_rng_t *solve_rng = solver_rand_stream(&rng);
+    solve_island(&ctx, exchange->qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, exchange->param,
+                 exchange, NULL, NULL);
+    solver_rand_stream(solve_rng);
+
+    free(solution_list);
+    free(energy_list);
+    free(solution_counts);
+    free(Qindex);
+}
+
+// Run param->num_islands outer loops at the same time, each on its own thread, trading their best
+// solutions through solution_list (see parameters_t.num_islands)
+//
+// Arguments as for solve_island
+// @return the number of sub QUBOs the islands solved
+static long solve_islands(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list,
+                          double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param) {
+    const int qubo_size = qubo->size;
+    island_exchange_t exchange;
+
+    exchange.ctx = ctx;
+    exchange.qubo = qubo;
+    exchange.param = param;
+    exchange.solution_list = solution_list;
+    exchange.energy_list = energy_list;
+    exchange.solution_counts = solution_counts;
+    exchange.Qindex = Qindex;
+    exchange.QLEN = QLEN;
+    exchange.num_nq_solutions = 0;
+    exchange.pool = solution_pool_create(QLEN + 1, qubo_size);
+    exchange.numPartCalls = 0;
+    exchange.stop = false;
+    for (int i = 0; i < QLEN + 1; i++) {
+        energy_list[i] = BIGNEGFP;
+        solution_counts[i] = 0;
+        for (int j = 0; j < qubo_size; j++) {
+            solution_list[i][j] = 0;
+        }
+    }
+
+    // the seeds are drawn before any island runs
+    if (GETMEM(exchange.seeds, uint64_t, param->num_islands) == NULL) BADMALLOC
+    for (int i = 0; i < param->num_islands; i++) exchange.seeds[i] = solver_rand64();
+
+    struct thread_pool *threads = thread_pool_create(param->num_islands);
+    thread_pool_run(threads, param->num_islands, island_task, &exchange);
+    thread_pool_free(threads);
+
+    free(exchange.seeds);
+    solution_pool_free(exchange.pool);
+    return exchange.numPartCalls;
+}
+
+// The body of solve_qubo_context and solve_qubo_state, with resume and reuse as for solve_island
+static void solve_tables(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list,
+                         double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param,
+                         const qbsolv_state_t *resume, solver_workspace_t *reuse) {
+    const int qubo_size = qubo->size;
+    const bool quiet = ctx->quiet;
+    qbsolv_context_t quiet_ctx;
+    if (quiet) {  // a quiet solve prints no progress and no matrix either
+        quiet_ctx = *ctx;
+        quiet_ctx.verbose = 0;
+        quiet_ctx.write_matrix = false;
+        ctx = &quiet_ctx;
+    }
+    double sign = ctx->find_max ? 1.0 : -1.0;
+    long numPartCalls;
+
+    // every search stops at the deadline, checked every few thousand bit flips
+    ctx->start = solver_wall_seconds();
+    ctx->deadline = ctx->start + ctx->timeout;
+
+    // every random number of the solve comes from its own generator, seeded by the context
+    solver_rng_t rng;
+    solver_rng_seed(&rng, ctx->seed);
+    solver_rng_t *caller_rng = solver_rand_stream(&rng);
+
+    if (param->num_islands > 1 && resume == NULL) {
+        numPartCalls = solve_islands(ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, param);
+    } else {
+        numPartCalls = solve_island(ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, param, NULL,
+                                    resume, reuse);
+    }
+
+    // all done print results if needed
+    int8_t *Qbest = &solution_list[Qindex[0]][0];
+    double best_energy = energy_list[Qindex[0]];
+    if (ctx->write_matrix && qubo->layout != QUBO_SPARSE) print_solution_and_qubo(ctx, Qbest, qubo_size, qubo->dense);
+
+    if (ctx->verbose == 0 && !quiet) {
         // printf(" evaluated solution %8.2lf\n",
         //     sign * Simple_evaluate(Qbest, qubo_size, (const double **)qubo));
-        print_output(qubo_size, Qbest, numPartCalls, best_energy * sign, CPSECONDS, param);
+        print_output(ctx, qubo_size, Qbest, numPartCalls, best_energy * sign, solve_seconds(ctx), param);
     }
 
-    free(solution);
-    free(tabu_solution);
-    free(flip_cost);
-    free(index);
-    free(TabuK);
-    free(Pcompress);
+    solver_rand_stream(caller_rng);
+}
 
-    return;
+// Entry into the overall solver from the main program, see solve_island for the algorithm
+//
+// With param->num_islands above 1 that many outer loops run side by side and share their best
+// solutions, see solve_islands.
+//
+// @param[in,out] ctx the options of the run and its output state, which nothing else touches, so
+//      solves with different contexts can run at the same time
+// @param qubo The QUBO matrix to be solved, in any of the supported layouts
+// @param[out] solution_list output solution table
+// @param[out] energy_list output energy table
+// @param[out] solution_counts output occurence table
+// @param[out] Qindex order of entries in the solution table
+// @param QLEN Number of entries in the solution table
+// @param[in,out] param Other parameters to the solve method that have default values.
+void solve_qubo_context(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list, double *energy_list,
+                        int *solution_counts, int *Qindex, int QLEN, parameters_t *param) {
+    solve_tables(ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, param, NULL, NULL);
+}
+
+// solve_qubo_context in the scratch memory and threads of a workspace kept from one solve to the
+// next, so a long running caller allocates and starts them once.  Solves with param->num_islands
+// above 1 create their own, as every island needs them.
+//
+// @param work a workspace of at least qubo->size variables in sub QUBOs of param->sub_size
+//      variables, from solver_workspace_create
+// Other arguments as for solve_qubo_context
+void solve_qubo_workspace(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list,
+                          double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param,
+                          solver_workspace_t *work) {
+    solve_tables(ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, param, NULL, work);
+}
+
+// Get an empty state for a QUBO of size variables with solution tables of QLEN entries
+qbsolv_state_t *qbsolv_state_create(int32_t size, int32_t QLEN) {
+    qbsolv_state_t *state;
+    if (GETMEM(state, qbsolv_state_t, 1) == NULL) BADMALLOC
+    state->size = size;
+    state->QLEN = QLEN;
+    state->solution_list = (int8_t **)malloc2D(QLEN + 1, size, sizeof(int8_t));
+    if (GETMEM(state->energy_list, double, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(state->solution_counts, int, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(state->Qindex, int, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(state->solution, int8_t, size) == NULL) BADMALLOC
+    if (GETMEM(state->flip_cost, double, size) == NULL) BADMALLOC
+    state->energy = 0.0;
+    state->valid = false;
+    return state;
+}
+
+// Release a state from qbsolv_state_create
+void qbsolv_state_free(qbsolv_state_t *state) {
+    if (state == NULL) return;
+    free(state->solution_list);
+    free(state->energy_list);
+    free(state->solution_counts);
+    free(state->Qindex);
+    free(state->solution);
+    free(state->flip_cost);
+    free(state);
+}
+
+// The value of entry (row, col), row <= col, of qubo
+static double qubo_entry(const qubo_matrix_t *qubo, int row, int col) {
+    if (qubo->layout != QUBO_SPARSE) return qubo->dense[row][col];
+    const sparse_qubo_t *sparse = qubo->sparse;
+    if (row == col) return sparse->diagonal[row];
+    const int32_t *first = sparse->columns + sparse->row_start[row];
+    const int32_t *last = sparse->columns + sparse->row_start[row + 1];
+    const int32_t *found = std::lower_bound(first, last, col);
+    return sparse->values[found - sparse->columns];
+}
+
+// Set entry (row, col), row <= col, of qubo and every copy of it the layout keeps
+static void qubo_set_entry(qubo_matrix_t *qubo, int row, int col, double value) {
+    if (qubo->layout == QUBO_SPARSE) {
+        // the sparse QUBO is shared read only by the solves, changes are made between them
+        sparse_qubo_t *sparse = qubo->sparse;
+        if (row == col) {
+            sparse->diagonal[row] = value;
+            return;
+        }
+        for (int k = 0; k < 2; k++, std::swap(row, col)) {
+            const int32_t *first = sparse->columns + sparse->row_start[row];
+            const int32_t *last = sparse->columns + sparse->row_start[row + 1];
+            sparse->values[std::lower_bound(first, last, col) - sparse->columns] = value;
+        }
+        return;
+    }
+    qubo->dense[row][col] = value;
+    if (qubo->layout == QUBO_SYMMETRIC) qubo->dense[col][row] = value;
+    if (qubo->layout == QUBO_FLOAT) qubo->single[row][col] = qubo->single[col][row] = (float)value;
+    if (qubo->layout == QUBO_INTEGER) qubo->integer[row][col] = qubo->integer[col][row] = (int32_t)value;
+}
+
+// true if qubo can hold value at (row, col) without being rebuilt
+static bool qubo_change_fits(const qubo_matrix_t *qubo, const qubo_change_t *change) {
+    int row = change->row, col = change->col;
+    if (row < 0 || row > col || col >= qubo->size) return false;
+    if (qubo->layout == QUBO_INTEGER) {
+        double value = change->value;
+        if (value != floor(value) || value <= INT32_MIN || value > INT32_MAX) return false;
+    }
+    if (qubo->layout == QUBO_SPARSE && row != col) {
+        const sparse_qubo_t *sparse = qubo->sparse;
+        const int32_t *first = sparse->columns + sparse->row_start[row];
+        const int32_t *last = sparse->columns + sparse->row_start[row + 1];
+        if (!std::binary_search(first, last, col)) return false;
+    }
+    return true;
+}
+
+// Set entries of qubo to new values, bringing the energies of the solutions of state and the flip
+// costs of its solution up to date
+//
+// A change of delta at (row, col) changes the energy of a solution x by delta x[row] x[col], and
+// the flip cost of row by (1 - 2 x[row]) delta x[col] and of col the other way round, so each
+// change costs O(1) for the solution and for each of the solution tables.
+//
+// @param[in,out] qubo the QUBO, in any of the supported layouts
+// @param[in,out] state the state to bring up to date, or NULL
+// @param changes the entries to set
+// @param num_changes the number of changes
+// @return 0, or -1 with nothing changed when the QUBO would have to be rebuilt, or state is for a QUBO
+//      of another size
+int qubo_apply_changes(qubo_matrix_t *qubo, qbsolv_state_t *state, const qubo_change_t *changes, int num_changes) {
+    if (state != NULL && state->size != qubo->size) return -1;
+    for (int c = 0; c < num_changes; c++) {
+        if (!qubo_change_fits(qubo, &changes[c])) return -1;
+    }
+    for (int c = 0; c < num_changes; c++) {
+        int row = changes[c].row, col = changes[c].col;
+        double delta = changes[c].value - qubo_entry(qubo, row, col);
+        qubo_set_entry(qubo, row, col, changes[c].value);
+        if (state == NULL || !state->valid) continue;
+
+        for (int i = 0; i < state->QLEN; i++) {
+            int8_t *x = state->solution_list[i];
+            if (state->energy_list[i] != BIGNEGFP && x[row] && x[col]) state->energy_list[i] += delta;
+        }
+        int8_t *x = state->solution;
+        if (x[row] && x[col]) state->energy += delta;
+        if (row == col) {
+            state->flip_cost[row] += (1 - 2 * x[row]) * delta;
+        } else {
+            state->flip_cost[row] += (1 - 2 * x[row]) * delta * x[col];
+            state->flip_cost[col] += (1 - 2 * x[col]) * delta * x[row];
+        }
+    }
+    return 0;
+}
+
+// Solve into the solution tables of state, resuming from it once it holds the result of a solve,
+// see solve_qubo_context
+//
+// @param[in,out] ctx the options of the run and its output state
+// @param qubo The QUBO matrix to be solved, changed since the last solve by qubo_apply_changes only
+// @param[in,out] state the tables to solve into, and what the next solve resumes from
+// @param[in,out] param Other parameters to the solve method that have default values.
+void solve_qubo_state(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, qbsolv_state_t *state, parameters_t *param) {
+    solve_tables(ctx, qubo, state->solution_list, state->energy_list, state->solution_counts, state->Qindex,
+                 state->QLEN, param, state->valid ? state : NULL, NULL);
+
+    // the next solve resumes from the best solution, evaluated once here
+    int8_t *best = state->solution_list[state->Qindex[0]];
+    for (int i = 0; i < state->size; i++) state->solution[i] = best[i];
+    state->energy = qubo_evaluate(state->solution, qubo, state->flip_cost);
+    state->valid = true;
+}
+
+// The QUBOs of solve_qubo_batch and where their results go
+typedef struct batch_t {
+    const qbsolv_context_t *ctx;
+    const qubo_matrix_t *qubos;
+    int num_qubos;
+    int QLEN;
+    parameters_t param;
+    int max_size;      // the size of the largest QUBO, what the tables of the workers hold
+    uint64_t *seeds;   // the seed of each solve
+    int64_t *offsets;  // where the solution of each QUBO starts in solutions
+    int8_t *solutions;
+    double *energies;
+    std::atomic<int> next;  // the next QUBO a worker takes
+} batch_t;
+
+// A worker of solve_qubo_batch, solving QUBOs until none is left
+static void batch_worker(void *data, int worker) {
+    (void)worker;
+    batch_t *batch = (batch_t *)data;
+    const int QLEN = batch->QLEN;
+    int8_t **solution_list;
+    double *energy_list;
+    int *solution_counts, *Qindex;
+
+    // tables and scratch memory for the largest QUBO, the smaller ones use the start of each row
+    solution_list = (int8_t **)malloc2D(QLEN + 1, batch->max_size, sizeof(int8_t));
+    if (GETMEM(energy_list, double, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(solution_counts, int, QLEN + 1) == NULL) BADMALLOC
+    if (GETMEM(Qindex, int, QLEN + 1) == NULL) BADMALLOC
+    solver_workspace_t *work = solver_workspace_create(batch->max_size, batch->param.sub_size);
+
+    for (int q = batch->next++; q < batch->num_qubos; q = batch->next++) {
+        const qubo_matrix_t *qubo = &batch->qubos[q];
+        qbsolv_context_t ctx = *batch->ctx;
+        ctx.quiet = true;
+        ctx.num_outputs = 0;
+        ctx.seed = batch->seeds[q];
+        parameters_t param = batch->param;
+        solve_tables(&ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, &param, NULL, work);
+
+        int8_t *best = solution_list[Qindex[0]];
+        for (int i = 0; i < qubo->size; i++) batch->solutions[batch->offsets[q] + i] = best[i];
+        batch->energies[q] = energy_list[Qindex[0]];
+    }
+
+    free(solution_list);
+    free(energy_list);
+    free(solution_counts);
+    free(Qindex);
+    solver_workspace_free(work);
+}
+
+// Solve many independent QUBOs on a pool of workers
+//
+// The QUBOs are handed out one at a time as the workers become free, so a few large ones do not
+// hold up the rest.
+//
+// @param ctx the options every solve runs with, and the seed the seeds of the solves are drawn from
+// @param qubos the QUBOs to be solved, in any of the supported layouts
+// @param num_qubos the number of QUBOs
+// @param QLEN Number of entries in the solution table of each solve
+// @param param Other parameters to the solve method, the same for every QUBO
+// @param num_workers the number of QUBOs solved at the same time
+// @param[out] solutions the best solution of each QUBO, one after the other
+// @param[out] energies the energy of each best solution
+void solve_qubo_batch(const qbsolv_context_t *ctx, const qubo_matrix_t *qubos, int num_qubos, int QLEN,
+                      const parameters_t *param, int num_workers, int8_t *solutions, double *energies) {
+    batch_t batch;
+    batch.ctx = ctx;
+    batch.qubos = qubos;
+    batch.num_qubos = num_qubos;
+    batch.QLEN = QLEN;
+    batch.param = *param;
+    batch.param.num_threads = 1;  // the workers are the threads
+    batch.param.num_islands = 1;
+    batch.param.progress = NULL;
+    batch.param.progress_data = NULL;
+    batch.param.initial_solutions = NULL;
+    batch.param.num_initial_solutions = 0;
+    batch.solutions = solutions;
+    batch.energies = energies;
+    batch.next = 0;
+
+    if (GETMEM(batch.seeds, uint64_t, num_qubos) == NULL) BADMALLOC
+    if (GETMEM(batch.offsets, int64_t, num_qubos) == NULL) BADMALLOC
+    batch.max_size = 0;
+    int64_t offset = 0;
+    for (int q = 0; q < num_qubos; q++) {
+        batch.offsets[q] = offset;
+        offset += qubos[q].size;
+        batch.max_size = MAX(batch.max_size, qubos[q].size);
+    }
+
+    // the seeds are drawn in order before any QUBO is solved
+    solver_rng_t rng;
+    solver_rng_seed(&rng, ctx->seed);
+    solver_rng_t *caller_rng = solver_rand_stream(&rng);
+    for (int q = 0; q < num_qubos; q++) batch.seeds[q] = solver_rand64();
+    solver_rand_stream(caller_rng);
+
+    num_workers = MAX(1, MIN(num_workers, num_qubos));
+    struct thread_pool *threads = thread_pool_create(num_workers);
+    thread_pool_run(threads, num_workers, batch_worker, &batch);
+    thread_pool_free(threads);
+
+    free(batch.seeds);
+    free(batch.offsets);
+}
+
+// The context of the globals in extern.h, what the entry points without one solve with
+static qbsolv_context_t global_context() {
+    qbsolv_context_t ctx = default_context();
+    ctx.verbose = Verbose_;
+    ctx.find_max = findMax_;
+    strncpy(ctx.algo, algo_, sizeof(ctx.algo) - 1);
+    ctx.algo[sizeof(ctx.algo) - 1] = '\0';
+    ctx.target_set = TargetSet_;
+    ctx.target = Target_;
+    ctx.timeout = Time_;
+    ctx.tabu_tenure = Tlist_;
+    ctx.write_matrix = WriteMatrix_;
+    ctx.out = outFile_;
+    ctx.num_outputs = numsolOut_;
+    // drawn from rand(), so srand() still picks the run as it did before solves had a seed
+    ctx.seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+    return ctx;
+}
+
+// solve_qubo_context() with the options and output state of the globals in extern.h
+void solve_qubo(const qubo_matrix_t *qubo, int8_t **solution_list, double *energy_list, int *solution_counts,
+                int *Qindex, int QLEN, parameters_t *param) {
+    qbsolv_context_t ctx = global_context();
+    solve_qubo_context(&ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, param);
+    numsolOut_ = ctx.num_outputs;
+}
+
+// Entry into the overall solver for an upper triangular 2d array, see solve_qubo_context()
+void solve_context(qbsolv_context_t *ctx, double **qubo, const int qubo_size, int8_t **solution_list,
+                   double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param) {
+    qubo_matrix_t matrix = dense_qubo_matrix(qubo, qubo_size);
+    solve_qubo_context(ctx, &matrix, solution_list, energy_list, solution_counts, Qindex, QLEN, param);
+}
+
+// Entry into the overall solver for an upper triangular 2d array, with the globals in extern.h
+void solve(double **qubo, const int qubo_size, int8_t **solution_list, double *energy_list, int *solution_counts,
+           int *Qindex, int QLEN, parameters_t *param) {
+    qubo_matrix_t matrix = dense_qubo_matrix(qubo, qubo_size);
+    solve_qubo(&matrix, solution_list, energy_list, solution_counts, Qindex, QLEN, param);
 }
 
 #ifdef __cplusplus
@@ -12,12 +12,61 @@
 */
 #pragma once
 
+#include "qbsolv.h"
 #include "util.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Scratch memory for one solve, created once up front so that the outer loop does no heap allocation
+typedef struct solver_workspace_t {
+    // The number of variables of the full QUBO
+    int size;
+    // Sweep order of local_search_1bit on the full QUBO, size entries
+    int *order;
+    // The number of variables of a sub QUBO
+    int sub_size;
+    // The variables extracted into the current sub QUBO, sub_size entries
+    int *compress;
+    // The sub QUBO and its solution, filled by reduce_solve_projection
+    double **sub_qubo;
+    int8_t *sub_solution;
+    // Buffers of the tabu search run on the sub QUBO, sub_size entries each
+    double *sub_flip_cost;
+    int8_t *sub_best;
+    int *sub_tabu;
+    int *sub_index;
+    int *sub_order;
+    // Move selector of the full tabu passes, NULL unless the QUBO is QUBO_SPARSE
+    struct move_tree *tree;
+    // Buffers of the outer loop on the full QUBO, size entries each, NULL until a solve of the full
+    // QUBO uses the workspace
+    int8_t *solution;
+    int8_t *tabu_solution;
+    double *flip_cost;
+    int *index;
+    int *tabu;
+    int *pcompress;
+    // Bit packed copies of the solution table of the outer loop, of pool_rows rows
+    struct solution_pool *pool;
+    int pool_rows;
+    // The threads and buffers of the submatrix passes, NULL until a solve with num_threads above 1
+    // uses the workspace
+    struct sub_batch_t *batch;
+} solver_workspace_t;
+
+// Allocate the scratch memory for a solve of size variables in sub QUBOs of sub_size variables
+solver_workspace_t *solver_workspace_create(int size, int sub_size);
+
+// Release a workspace created by solver_workspace_create
+void solver_workspace_free(solver_workspace_t *work);
+
+// solve_qubo_context in the scratch memory and threads of work, which are kept for the next solve
+void solve_qubo_workspace(qbsolv_context_t *ctx, const qubo_matrix_t *qubo, int8_t **solution_list,
+                          double *energy_list, int *solution_counts, int *Qindex, int QLEN, parameters_t *param,
+                          solver_workspace_t *work);
+
 // This function Simply evaluates the objective function for a given solution.
 double Simple_evaluate(const int8_t *const solution, const uint qubo_size, const double **const qubo);
 
@@ -28,29 +77,112 @@ double evaluate(int8_t *const solution, const uint qubo_size, const double **con
 double evaluate_1bit(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
                      const double **const qubo, double *const flip_cost);
 
+// This function evaluates the objective function for a given solution on a sparse QUBO.
+double evaluate_sparse(int8_t *const solution, const sparse_qubo_t *const qubo, double *const flip_cost);
+
+// Flips a given bit in the solution of a sparse QUBO, and calculates the new energy.
+double evaluate_1bit_sparse(const double old_energy, const uint bit, int8_t *const solution,
+                            const sparse_qubo_t *const qubo, double *const flip_cost);
+
+// This function evaluates the objective function for a given solution on a symmetric QUBO.
+double evaluate_symmetric(int8_t *const solution, const uint qubo_size, const double **const qubo,
+                          double *const flip_cost);
+
+// Flips a given bit in the solution of a symmetric QUBO, and calculates the new energy.
+double evaluate_1bit_symmetric(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                               const double **const qubo, double *const flip_cost);
+
+// Flips a given bit in the solution of a single precision QUBO, and calculates the new energy.
+double evaluate_1bit_float(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                           const float **const qubo, double *const flip_cost);
+
+// This function evaluates the objective function for a given solution on an integer QUBO.
+double evaluate_integer(int8_t *const solution, const uint qubo_size, const int32_t **const qubo,
+                        double *const flip_cost);
+
+// Flips a given bit in the solution of an integer QUBO, and calculates the new energy.
+double evaluate_1bit_integer(const double old_energy, const uint bit, int8_t *const solution, const uint qubo_size,
+                             const int32_t **const qubo, double *const flip_cost);
+
+// Evaluates the objective function for a given solution, on any supported layout
+double qubo_evaluate(int8_t *const solution, const qubo_matrix_t *const qubo, double *const flip_cost);
+
+// Flips a given bit in the solution and calculates the new energy, on any supported layout
+double qubo_evaluate_1bit(const double old_energy, const uint bit, int8_t *const solution,
+                          const qubo_matrix_t *const qubo, double *const flip_cost);
+
+// Wrap an upper triangular 2d array as a QUBO matrix
+qubo_matrix_t dense_qubo_matrix(double **qubo, int qubo_size);
+
+// Tabu iterations between looks at the clock for the deadline of the solve
+#define DEADLINE_ITERATIONS 64
+
+// Work of a local search between looks at the clock, in candidate bits plus qubo_size a bit flipped
+#define DEADLINE_WORK 262144
+
+// true once the solve of ctx is past its deadline or cancelled
+bool solve_stopped(const qbsolv_context_t *ctx);
+
 // Tries to improve the current solution Q by flipping single bits.
-double local_search_1bit(double energy, int8_t *solution, uint qubo_size, double **qubo, double *flip_cost,
-                         int64_t *bit_flips);
+double local_search_1bit(const qbsolv_context_t *ctx, double energy, int8_t *solution, const qubo_matrix_t *qubo,
+                         double *flip_cost, int64_t *bit_flips, int *order);
 
 // Performs a local Max search improving the solution and returning the last evaluated value
-double local_search(int8_t *solution, int qubo_size, double **qubo, double *flip_cost, int64_t *bit_flips);
+double local_search(const qbsolv_context_t *ctx, int8_t *solution, const qubo_matrix_t *qubo, double *flip_cost,
+                    int64_t *bit_flips, int *order);
 
 // This function is called by solve to execute a tabu search
-double tabu_search(int8_t *solution, int8_t *best, uint qubo_size, double **qubo, double *flip_cost, int64_t *bit_flips,
-                   int64_t iter_max, int *TabuK, double target, bool target_set, int *index, int nTabu);
+double tabu_search(const qbsolv_context_t *ctx, int8_t *solution, int8_t *best, const qubo_matrix_t *qubo,
+                   double *flip_cost, int64_t *bit_flips, int64_t iter_max, int *TabuK, double target, bool target_set,
+                   int *index, int nTabu, int *order, struct move_tree *tree, const double *energy);
 
 // reduce() computes a subQUBO (val_s) from large QUBO (val)
 void reduce(int *Icompress, double **qubo, uint sub_qubo_size, uint qubo_size, double **sub_qubo, int8_t *solution,
             int8_t *sub_solution);
 
+// reduce_sparse() computes a subQUBO from a large sparse QUBO
+void reduce_sparse(int *Icompress, const sparse_qubo_t *qubo, uint sub_qubo_size, double **sub_qubo,
+                   int8_t *solution, int8_t *sub_solution);
+
+// reduce_symmetric() computes a subQUBO from a large symmetric QUBO
+void reduce_symmetric(int *Icompress, double **qubo, uint sub_qubo_size, uint qubo_size, double **sub_qubo,
+                      int8_t *solution, int8_t *sub_solution);
+
+// reduce_flip_cost() computes the subQUBO of reduce() from the flip costs of solution in O(sub_qubo_size^2)
+void reduce_flip_cost(int *Icompress, const qubo_matrix_t *qubo, uint sub_qubo_size, double **sub_qubo,
+                      int8_t *solution, int8_t *sub_solution, const double *flip_cost);
+
+// true if reduce_flip_cost() applies to the layout of qubo
+bool reduce_flip_cost_layout(const qubo_matrix_t *qubo);
+
+// Computes a subQUBO from a large QUBO in any of the supported layouts
+void qubo_reduce(int *Icompress, const qubo_matrix_t *qubo, uint sub_qubo_size, double **sub_qubo, int8_t *solution,
+                 int8_t *sub_solution);
+
 // solv_submatrix() performs QUBO optimization on a subregion.
-double solv_submatrix(int8_t *solution, int8_t *best, uint qubo_size, double **qubo, double *flip_cost,
-                      int64_t *bit_flips, int *TabuK, int *index);
+double solv_submatrix(const qbsolv_context_t *ctx, int8_t *solution, int8_t *best, const qubo_matrix_t *qubo,
+                      double *flip_cost, int64_t *bit_flips, int *TabuK, int *index, int *order);
+
+// Tabu search on a sub QUBO using the sub problem buffers of a workspace, the body of tabu_sub_sample
+void tabu_sub_solve(const qbsolv_context_t *ctx, double **sub_qubo, int subMatrix, int8_t *sub_solution,
+                    solver_workspace_t *work);
+
+// Tabu search on a sub QUBO of 32, 47 or 64 variables with a kernel specialized for that size,
+// returns false if there is none for subMatrix
+bool tabu_sub_solve_fixed(const qbsolv_context_t *ctx, double **sub_qubo, int subMatrix, int8_t *sub_solution);
+
+// reduce_solve() extracts the sub QUBO of the variables Icompress and solves it into work->sub_solution
+void reduce_solve(const qbsolv_context_t *ctx, int *Icompress, const qubo_matrix_t *qubo, int subMatrix,
+                  int8_t *solution, const double *flip_cost, parameters_t *param, solver_workspace_t *work);
+
+// project_solution() writes a sub QUBO solution back into solution and returns the number of changes
+int project_solution(const qbsolv_context_t *ctx, int *Icompress, int subMatrix, int8_t *sub_solution,
+                     int8_t *solution, const qubo_matrix_t *qubo, double *flip_cost, double *energy);
 
 // reduce_solv_projection reduces from a submatrix solves the QUBO projects the solution and
 //      returns the number of changes
-int reduce_solve_projection(int *Icompress, double **qubo, int qubo_size, int subMatrix, int8_t *solution,
-                            parameters_t *param);
+int reduce_solve_projection(const qbsolv_context_t *ctx, int *Icompress, const qubo_matrix_t *qubo, int subMatrix,
+                            int8_t *solution, parameters_t *param, solver_workspace_t *work);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,288 @@
+/*
+ Copyright 2017 D-Wave Systems Inc
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+// Tabu search on sub QUBOs of a size known at compile time.
+//
+// solv_submatrix runs tabu_search on every sub QUBO with at least 20000 candidate flips per
+// variable, so for the usual sub_size (47) nearly all of the solver time is spent here. The
+// sub_tabu_search<N> below is the same search as tabu_search on a dense matrix, step for step
+// and random draw for random draw, so the sub solutions are identical; what changes is that
+// the sub QUBO is copied into a mirrored N x N array and every buffer is a fixed size array on
+// the stack, so every loop has a constant trip count and the whole state stays in L1.
+
+#include "macros.h"
+#include "solver.h"
+#include "util.h"
+
+#include <limits.h>
+
+// The state of one sub QUBO tabu search of N variables
+template <int N>
+struct sub_state {
+    // the sub QUBO, with the upper triangle mirrored into the lower so each variable is one row
+    double qubo[N][N];
+    double flip_cost[N];
+    // solution[i] as -1.0 or 1.0, the sign of the flip_cost updates, so they vectorize
+    double spin[N];
+    int8_t solution[N];
+    int8_t best[N];
+    int tabu[N];  // the last iteration at which each variable is tabu
+    int index[N];
+    int order[N];
+};
+
+// evaluate on the mirrored matrix, the sums are taken in the same order as evaluate
+template <int N>
+static double sub_evaluate(sub_state<N> *s) {
+    double result = 0.0;
+
+    for (int ii = 0; ii < N; ii++) {
+        const double *const row = s->qubo[ii];
+        double row_sum = 0.0;
+        double col_sum = 0.0;
+
+        for (int jj = ii + 1; jj < N; jj++)
+            if (s->solution[jj]) row_sum += row[jj];
+
+        for (int jj = 0; jj < ii; jj++)
+            if (s->solution[jj]) col_sum += row[jj];
+
+        double contrib = row_sum + col_sum + row[ii];
+        if (s->solution[ii] == 1) {
+            result += row_sum + row[ii];
+            s->flip_cost[ii] = -contrib;
+        } else {
+            s->flip_cost[ii] = contrib;
+        }
+    }
+
+    return result;
+}
+
+// evaluate_1bit on the mirrored matrix
+//
+// The whole row of bit is applied, including its own entry, and flip_cost[bit] is set
+// afterwards, which leaves every other entry with the same value evaluate_1bit computes.
+template <int N>
+static double sub_evaluate_1bit(sub_state<N> *s, const double old_energy, const int bit) {
+    const double *const row = s->qubo[bit];
+    double result = old_energy + s->flip_cost[bit];
+    double bit_cost = -s->flip_cost[bit];
+
+    s->solution[bit] = 1 - s->solution[bit];
+    s->spin[bit] = -s->spin[bit];
+
+    if (s->solution[bit] == 0) {
+        for (int ii = 0; ii < N; ii++) s->flip_cost[ii] += row[ii] * s->spin[ii];
+    } else {
+        for (int ii = 0; ii < N; ii++) s->flip_cost[ii] -= row[ii] * s->spin[ii];
+    }
+    s->flip_cost[bit] = bit_cost;
+
+    return result;
+}
+
+// local_search_1bit on a sub QUBO
+template <int N>
+static double sub_local_search_1bit(sub_state<N> *s, double energy, int64_t *bit_flips) {
+    int kkstr = 0, kkend = N, kkinc;
+    int *index = s->order;
+
+    for (int kk = 0; kk < N; kk++) index[kk] = kk;
+
+    bool improve = true;
+    while (improve) {
+        improve = false;
+
+        if (kkstr == 0) {
+            shuffle_index(index, N);
+            kkstr = N - 1;
+            kkinc = -1;
+            kkend = -1;
+        } else {
+            kkstr = 0;
+            kkinc = 1;
+            kkend = N;
+        }
+
+        for (int kk = kkstr; kk != kkend; kk = kk + kkinc) {
+            int bit = index[kk];
+            (*bit_flips)++;
+            if (s->flip_cost[bit] > 0.0) {
+                energy = sub_evaluate_1bit(s, energy, bit);
+                improve = true;
+            }
+        }
+    }
+    return energy;
+}
+
+// tabu_search on a sub QUBO, as called by solv_submatrix: no target, fixed tenure, stops at the deadline or
+// cancellation of ctx
+template <int N>
+static double sub_tabu_search(const qbsolv_context_t *ctx, sub_state<N> *s, int64_t *bit_flips, int64_t iter_max,
+                              int nTabu) {
+    int last_bit = 0;
+    bool brk;
+    double best_energy;
+    double Vlastchange;
+    double sign = ctx->find_max ? 1.0 : -1.0;
+    int64_t thisIter;
+    int64_t increaseIter;
+    int numIncrease = 900;
+    double howFar;
+
+    best_energy = sub_local_search_1bit(s, sub_evaluate(s), bit_flips);
+    val_index_sort(s->index, s->flip_cost, N);
+    thisIter = iter_max - (*bit_flips);
+    increaseIter = thisIter / 2;
+    Vlastchange = best_energy;
+
+    for (int i = 0; i < N; i++) s->best[i] = s->solution[i];
+    for (int i = 0; i < N; i++) s->tabu[i] = 0;
+    int iteration = 1;
+
+    int kk, kkstr = 0, kkend = N, kkinc;
+    int bit_cycle_1 = N, bit_cycle_2 = N, bit_cycle = 0;
+    while (*bit_flips < iter_max) {
+        double neighbour_best = BIGNEGFP;
+        brk = false;
+        if (kkstr == 0) {
+            kkstr = N - 1;
+            kkinc = -1;
+            kkend = -1;
+        } else {
+            kkstr = 0;
+            kkinc = 1;
+            kkend = N;
+        }
+
+        for (kk = kkstr; kk != kkend; kk = kk + kkinc) {
+            int bit = s->index[kk];
+            if (s->tabu[bit] >= iteration) continue;
+            (*bit_flips)++;
+            double new_energy = Vlastchange + s->flip_cost[bit];
+            if (new_energy > best_energy && bit != bit_cycle_1) {
+                brk = true;
+                last_bit = bit;
+                float Delta_E = (float)(new_energy - best_energy);
+                new_energy = sub_evaluate_1bit(s, Vlastchange, bit);
+                Vlastchange = sub_local_search_1bit(s, new_energy, bit_flips);
+                val_index_sort_ns(s->index, s->flip_cost, N);
+                best_energy = Vlastchange;
+
+                for (int i = 0; i < N; i++) s->best[i] = s->solution[i];
+
+                howFar = ((double)(iter_max - (*bit_flips)) / (double)thisIter);
+                if (ctx->verbose > 3) {
+                    printf("Tabu new best %lf ,K=%d,last=%d, last_2=%d, cycle=%d,iteration = %" LONGFORMAT
+                           ""
+                           ", %lf, %d\n",
+                           Vlastchange * sign, last_bit, bit_cycle_1, bit_cycle_2, bit_cycle, (int64_t)(*bit_flips),
+                           howFar, brk);
+                }
+                if (Delta_E <= 0.00000001) bit_cycle++;
+                if (bit_cycle_2 == bit_cycle_1) bit_cycle++;
+                if (bit_cycle_2 == last_bit) bit_cycle++;
+                if (bit_cycle > 4) break;
+
+                bit_cycle_2 = bit_cycle_1;
+                bit_cycle_1 = last_bit;
+                if (howFar < 0.80 && numIncrease > 0) {
+                    if (ctx->verbose > 3) {
+                        printf("Increase Itermax %" LONGFORMAT ", %" LONGFORMAT "\n", iter_max,
+                               (iter_max + increaseIter));
+                    }
+                    iter_max += increaseIter;
+                    thisIter += increaseIter;
+                    numIncrease--;
+                }
+                break;
+            }
+            if (new_energy > neighbour_best) {
+                last_bit = bit;
+                neighbour_best = new_energy;
+            }
+        }
+
+        if (bit_cycle > 6) break;
+        if (iteration % DEADLINE_ITERATIONS == 0 && solve_stopped(ctx)) break;
+
+        if (!brk) Vlastchange = sub_evaluate_1bit(s, Vlastchange, last_bit);
+
+        s->tabu[last_bit] = iteration + (s->solution[N - 1] == 0 ? nTabu + 1 : nTabu - 1);
+
+        if (++iteration == INT_MAX / 2) {
+            for (int i = 0; i < N; i++) s->tabu[i] = MAX(0, s->tabu[i] - (iteration - 1));
+            iteration = 1;
+        }
+    }
+
+    for (int i = 0; i < N; i++) s->solution[i] = s->best[i];
+    for (int i = 0; i < N; i++) s->spin[i] = s->solution[i] ? 1.0 : -1.0;
+    double final_energy = sub_evaluate(s);
+
+    // tabu_search leaves the index sorted, which also advances the random numbers
+    val_index_sort(s->index, s->flip_cost, N);
+    return final_energy;
+}
+
+// Copy a sub QUBO in, solve it as solv_submatrix would and copy the solution out
+template <int N>
+static void sub_solve(const qbsolv_context_t *ctx, double **sub_qubo, int8_t *sub_solution) {
+    sub_state<N> s;
+
+    for (int i = 0; i < N; i++) {
+        for (int j = i; j < N; j++) s.qubo[i][j] = s.qubo[j][i] = sub_qubo[i][j];
+        s.solution[i] = sub_solution[i];
+        s.spin[i] = sub_solution[i] ? 1.0 : -1.0;
+    }
+
+    // the tenure and flip budget solv_submatrix picks for sizes from 20 to 99
+    int64_t bit_flips = 0;
+    int64_t iter_max = (int64_t)MAX((int64_t)3000, (int64_t)20000 * (int64_t)N);
+    sub_tabu_search<N>(ctx, &s, &bit_flips, iter_max, 10);
+
+    for (int i = 0; i < N; i++) sub_solution[i] = s.solution[i];
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tabu search on a sub QUBO with a kernel specialized for its size
+//
+// @param ctx the verbosity and sign of what is printed
+// @param sub_qubo the upper triangular sub QUBO
+// @param subMatrix the number of variables of the sub QUBO
+// @param[in,out] sub_solution the starting state, set to the best state found
+// @returns false, leaving sub_solution alone, if there is no kernel for subMatrix variables
+bool tabu_sub_solve_fixed(const qbsolv_context_t *ctx, double **sub_qubo, int subMatrix, int8_t *sub_solution) {
+    switch (subMatrix) {
+        case 32:
+            sub_solve<32>(ctx, sub_qubo, sub_solution);
+            return true;
+        case 47:
+            sub_solve<47>(ctx, sub_qubo, sub_solution);
+            return true;
+        case 64:
+            sub_solve<64>(ctx, sub_qubo, sub_solution);
+            return true;
+        default:
+            return false;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,122 @@
+/*
+ Copyright 2017 D-Wave Systems Inc
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+// The threads solve_qubo solves the sub QUBOs of a submatrix pass on.  The workers are
+// started once per solve and sleep on a condition variable between batches; each task
+// of a batch is a whole sub QUBO solve, milliseconds long, so the tasks are simply handed
+// out one at a time under the pool's mutex.
+
+#include "thread_pool.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct thread_pool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start;  // a batch was posted, or the pool is stopping
+    std::condition_variable done;   // the last worker left the batch
+
+    // the current batch, guarded by mutex
+    thread_pool_task task;
+    void *data;
+    int num_tasks;
+    int next_task;
+    int busy;         // workers that have not yet left the current batch
+    long generation;  // counts the batches, so a worker runs each one once
+    bool stop;
+};
+
+// Run tasks of the current batch until none is left, called with the mutex held
+static void run_tasks(thread_pool *pool, std::unique_lock<std::mutex> &lock) {
+    while (pool->next_task < pool->num_tasks) {
+        int task = pool->next_task++;
+        lock.unlock();
+        pool->task(pool->data, task);
+        lock.lock();
+    }
+}
+
+static void worker(thread_pool *pool) {
+    long seen = 0;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    for (;;) {
+        pool->start.wait(lock, [pool, seen] { return pool->stop || pool->generation != seen; });
+        if (pool->stop) return;
+        seen = pool->generation;
+        run_tasks(pool, lock);
+        if (--pool->busy == 0) pool->done.notify_all();
+    }
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Start a pool that runs tasks on num_threads threads
+//
+// @param num_threads the number of threads, including the one calling thread_pool_run
+// @returns a pool to be released with thread_pool_free
+struct thread_pool *thread_pool_create(int num_threads) {
+    thread_pool *pool = new thread_pool;
+    pool->task = NULL;
+    pool->data = NULL;
+    pool->num_tasks = 0;
+    pool->next_task = 0;
+    pool->busy = 0;
+    pool->generation = 0;
+    pool->stop = false;
+    for (int i = 1; i < num_threads; i++) pool->workers.push_back(std::thread(worker, pool));
+    return pool;
+}
+
+// Stop the threads of a pool and release it
+void thread_pool_free(struct thread_pool *pool) {
+    if (pool == NULL) return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stop = true;
+    }
+    pool->start.notify_all();
+    for (size_t i = 0; i < pool->workers.size(); i++) pool->workers[i].join();
+    delete pool;
+}
+
+// The number of threads tasks run on, including the caller
+int thread_pool_size(const struct thread_pool *pool) { return (int)pool->workers.size() + 1; }
+
+// Run task(data, i) for every i in 0 .. num_tasks - 1 and wait for all of them
+//
+// @param pool the threads to run on, the calling thread takes tasks as well
+// @param num_tasks the number of tasks of the batch
+// @param task the function called for each task
+// @param data passed to every call of task
+void thread_pool_run(struct thread_pool *pool, int num_tasks, thread_pool_task task, void *data) {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->task = task;
+    pool->data = data;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->busy = (int)pool->workers.size();
+    pool->generation++;
+    pool->start.notify_all();
+
+    run_tasks(pool, lock);
+    pool->done.wait(lock, [pool] { return pool->busy == 0; });
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,41 @@
+/*
+ Copyright 2017 D-Wave Systems Inc
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A fixed set of worker threads, started once and reused for every batch of tasks
+struct thread_pool;
+
+// A task of a batch, called once for each task number from 0 to num_tasks - 1
+typedef void (*thread_pool_task)(void *data, int task);
+
+// Start a pool that runs tasks on num_threads threads, the calling thread of
+// thread_pool_run being one of them, so num_threads - 1 threads are started
+struct thread_pool *thread_pool_create(int num_threads);
+
+// Stop the threads of a pool created by thread_pool_create and release it
+void thread_pool_free(struct thread_pool *pool);
+
+// The number of threads tasks run on, including the caller
+int thread_pool_size(const struct thread_pool *pool);
+
+// Run task(data, i) for i in 0 .. num_tasks - 1 spread over the threads of the pool,
+// returning once all of them have finished.  Tasks may run in any order.
+void thread_pool_run(struct thread_pool *pool, int num_tasks, thread_pool_task task, void *data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,6 +18,13 @@
 #include "extern.h"
 #include "qbsolv.h"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -47,16 +54,324 @@ void **malloc2D(uint rows, uint cols, uint size) {
     return (void **)big_array;
 }
 
-// this randomly sets the bit vector to 1 or 0
+// round a byte count or address up to a multiple of MATRIX_ALIGN
+static uintptr_t align_up(uintptr_t value) { return (value + MATRIX_ALIGN - 1) & ~(uintptr_t)(MATRIX_ALIGN - 1); }
+
+// malloc a block holding a table of rows pointers followed by data_space bytes of matrix
+// data that start on a MATRIX_ALIGN boundary, the block is released with a plain free()
+//
+// Large data areas are advised to use transparent huge pages, which takes effect when
+// the kernel has THP enabled in "madvise" or "always" mode and is ignored otherwise.
+static char **malloc_matrix_block(uint rows, uintptr_t data_space, char **data, const char *kind, uint cols) {
+    uintptr_t space = (uintptr_t)rows * sizeof(char *) + MATRIX_ALIGN + data_space;
+    char **big_array = (char **)malloc(space);
+    if (big_array == NULL) {
+        DL;
+        printf("\n\t%s error - memory request for %sX[%d][%d], %ld Mbytes  "
+               "denied\n\n",
+               pgmName_, kind, rows, cols, (long)(space / 1024 / 1024));
+        exit(9);
+    }
+    *data = (char *)align_up((uintptr_t)&big_array[rows]);
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (data_space >= HUGE_PAGE_MIN_BYTES) {
+        uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t start = ((uintptr_t)*data + page - 1) & ~(page - 1);
+        uintptr_t end = ((uintptr_t)*data + data_space) & ~(page - 1);
+        if (end > start) madvise((void *)start, end - start, MADV_HUGEPAGE);
+    }
+#endif
+    return big_array;
+}
+
+// create and pointer fill a 2d array of "size" for X[rows][cols] addressing,
+// with every row starting on a MATRIX_ALIGN boundary. Using only a single malloc
+//
+// The row stride is cols * size rounded up to MATRIX_ALIGN, so unlike malloc2D the
+// rows are not back to back, always go through the pointer table.
+void **malloc2D_aligned(uint rows, uint cols, uint size) {
+    uintptr_t stride = align_up((uintptr_t)cols * size);
+    char *ptr;
+    char **big_array = malloc_matrix_block(rows, (uintptr_t)rows * stride, &ptr, "aligned ", cols);
+
+    for (uint i = 0; i < rows; ++i) {
+        big_array[i] = ptr;
+        ptr += stride;
+    }
+    return (void **)big_array;
+}
+
+// create and pointer fill an upper triangular 2d array of "size" for
+// X[row][col] addressing with row <= col. Using only a single malloc
+//
+// Only the elements on and above the diagonal are stored, row after row.  The
+// pointer of row i is offset back by i elements so X[i][i] is the first element
+// stored for the row, which keeps the usual X[i][j] addressing for every kernel
+// that only touches the upper triangle.  Each row is placed so that X[i][0] would
+// fall on a MATRIX_ALIGN boundary, a vector loop over columns sees the same
+// alignment as in a full matrix, at the cost of less than MATRIX_ALIGN bytes a row.
+void **malloc2D_triangular(uint n, uint size) {
+    uintptr_t data_space = ((uintptr_t)n * (n + 1) / 2) * size + (uintptr_t)n * MATRIX_ALIGN;
+    char *data;
+    char **big_array = malloc_matrix_block(n, data_space, &data, "triangular ", n);
+
+    // row i holds n - i elements, its pointer is moved back i elements, which
+    // always stays inside the data as the earlier rows are at least that long
+    uintptr_t offset = 0;
+    for (uint i = 0; i < n; ++i) {
+        uintptr_t back = (uintptr_t)i * size;
+        offset = align_up(offset - back) + back;
+        big_array[i] = data + offset - back;
+        offset += (uintptr_t)(n - i) * size;
+    }
+    return (void **)big_array;
+}
+
+// Build a sparse QUBO from upper triangular (row, column, value) entries.
+//
+// The off diagonal entries are first scattered into the rows of both of their
+// variables in input order, then every row is re-emitted by walking the
+// variables in increasing order, which leaves the columns of each row sorted.
+// Repeated couplers are then next to each other in their rows and are summed.
+//
+// @param size is the number of variables
+// @param num_entries is the length of rows, cols and values
+// @param rows, cols, values the entries, entries with rows[k] == cols[k] are linear terms
+// @returns a QUBO to be released with sparse_qubo_free, or NULL when an entry is not
+//      0 <= rows[k] <= cols[k] < size
+sparse_qubo_t *sparse_qubo_create(int32_t size, int64_t num_entries, const int32_t *rows, const int32_t *cols,
+                                  const double *values) {
+    sparse_qubo_t *qubo;
+    int64_t *scatter_start, *fill;
+    int32_t *scatter_columns;
+    double *scatter_values;
+
+    if (size < 0) return NULL;
+    for (int64_t k = 0; k < num_entries; k++) {
+        if (rows[k] < 0 || rows[k] > cols[k] || cols[k] >= size) return NULL;
+    }
+
+    if (GETMEM(qubo, sparse_qubo_t, 1) == NULL) BADMALLOC
+    qubo->size = size;
+    if (GETMEM(qubo->row_start, int64_t, size + 1) == NULL) BADMALLOC
+    if (GETMEM(qubo->diagonal, double, size) == NULL) BADMALLOC
+    if (GETMEM(fill, int64_t, size + 1) == NULL) BADMALLOC
+
+    // count the neighbours of every variable and collect the linear terms
+    for (int32_t i = 0; i < size; i++) {
+        fill[i] = 0;
+        qubo->diagonal[i] = 0.0;
+    }
+    for (int64_t k = 0; k < num_entries; k++) {
+        if (rows[k] == cols[k]) {
+            qubo->diagonal[rows[k]] += values[k];
+        } else {
+            fill[rows[k]]++;
+            fill[cols[k]]++;
+        }
+    }
+    qubo->row_start[0] = 0;
+    for (int32_t i = 0; i < size; i++) qubo->row_start[i + 1] = qubo->row_start[i] + fill[i];
+
+    int64_t num_stored = qubo->row_start[size];
+    if (GETMEM(qubo->columns, int32_t, MAX(num_stored, 1)) == NULL) BADMALLOC
+    if (GETMEM(qubo->values, double, MAX(num_stored, 1)) == NULL) BADMALLOC
+    if (GETMEM(scatter_start, int64_t, size + 1) == NULL) BADMALLOC
+    if (GETMEM(scatter_columns, int32_t, MAX(num_stored, 1)) == NULL) BADMALLOC
+    if (GETMEM(scatter_values, double, MAX(num_stored, 1)) == NULL) BADMALLOC
+
+    // scatter the couplers into both of their rows, unordered
+    for (int32_t i = 0; i <= size; i++) scatter_start[i] = qubo->row_start[i];
+    for (int32_t i = 0; i < size; i++) fill[i] = scatter_start[i];
+    for (int64_t k = 0; k < num_entries; k++) {
+        if (rows[k] == cols[k]) continue;
+        scatter_columns[fill[rows[k]]] = cols[k];
+        scatter_values[fill[rows[k]]++] = values[k];
+        scatter_columns[fill[cols[k]]] = rows[k];
+        scatter_values[fill[cols[k]]++] = values[k];
+    }
+
+    // The structure is symmetric, so walking variable c in increasing order and
+    // appending c to the rows of all its neighbours sorts each row by column
+    for (int32_t i = 0; i < size; i++) fill[i] = qubo->row_start[i];
+    for (int32_t c = 0; c < size; c++) {
+        for (int64_t k = scatter_start[c]; k < scatter_start[c + 1]; k++) {
+            int32_t r = scatter_columns[k];
+            qubo->columns[fill[r]] = c;
+            qubo->values[fill[r]++] = scatter_values[k];
+        }
+    }
+
+    // sum the repeats of a coupler, the same in both of its rows, closing up the rows
+    int64_t stored = 0;
+    for (int32_t i = 0; i < size; i++) {
+        int64_t first = stored;
+        for (int64_t k = qubo->row_start[i]; k < qubo->row_start[i + 1]; k++) {
+            if (stored > first && qubo->columns[stored - 1] == qubo->columns[k]) {
+                qubo->values[stored - 1] += qubo->values[k];
+            } else {
+                qubo->columns[stored] = qubo->columns[k];
+                qubo->values[stored++] = qubo->values[k];
+            }
+        }
+        qubo->row_start[i] = first;
+    }
+    qubo->row_start[size] = stored;
+
+    free(scatter_values);
+    free(scatter_columns);
+    free(scatter_start);
+    free(fill);
+    return qubo;
+}
+
+// Release a QUBO created by sparse_qubo_create
+void sparse_qubo_free(sparse_qubo_t *qubo) {
+    if (qubo == NULL) return;
+    free(qubo->row_start);
+    free(qubo->columns);
+    free(qubo->values);
+    free(qubo->diagonal);
+    free(qubo);
+}
+
+// copy the upper triangle of a full size x size qubo into its lower triangle,
+// for the QUBO_SYMMETRIC layout
+void symmetrize_qubo(double **qubo, int size) {
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < i; j++) {
+            qubo[i][j] = qubo[j][i];
+        }
+    }
+}
+
+// create a full, mirrored single precision copy of an upper triangular qubo,
+// for the QUBO_FLOAT layout, the copy is a single allocation released with free()
+float **float_qubo_create(double **qubo, int size) {
+    float **single = (float **)malloc2D_aligned(size, size, sizeof(float));
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) {
+            single[i][j] = single[j][i] = (float)qubo[i][j];
+        }
+    }
+    return single;
+}
+
+// true if every coefficient of an upper triangular qubo is an integer that fits in an int32_t, and
+// so does its negation, the condition for the QUBO_INTEGER layout
+bool qubo_is_integral(double **qubo, int size) {
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) {
+            double value = qubo[i][j];
+            if (value != floor(value) || value <= INT32_MIN || value > INT32_MAX) return false;
+        }
+    }
+    return true;
+}
+
+// create a full, mirrored int32_t copy of an upper triangular qubo with integral coefficients,
+// for the QUBO_INTEGER layout, the copy is a single allocation released with free()
+int32_t **integer_qubo_create(double **qubo, int size) {
+    int32_t **integer = (int32_t **)malloc2D_aligned(size, size, sizeof(int32_t));
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) {
+            integer[i][j] = integer[j][i] = (int32_t)qubo[i][j];
+        }
+    }
+    return integer;
+}
+
+// the random numbers of the solver are xoshiro256**, a generator of four 64 bit words
+static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+static inline uint64_t rng_next(solver_rng_t *rng) {
+    uint64_t *s = rng->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Set rng to the stream of seed
+//
+// The state is filled from seed with splitmix64, as the xoshiro authors advise, so that no seed,
+// 0 included, gives the all zero state and nearby seeds give unrelated streams.
+void solver_rng_seed(solver_rng_t *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        rng->s[i] = z ^ (z >> 31);
+    }
+}
+
+// the generator of the calling thread when none was set, seeded the first time it is used
+static thread_local solver_rng_t thread_rng;
+static thread_local bool thread_rng_seeded = false;
+// the generator of the calling thread set by solver_rand_stream, NULL for thread_rng
+static thread_local solver_rng_t *rand_stream = NULL;
+
+static inline solver_rng_t *current_rng(void) {
+    if (rand_stream != NULL) return rand_stream;
+    if (!thread_rng_seeded) {
+        solver_rng_seed(&thread_rng, 17932241798878ULL);
+        thread_rng_seeded = true;
+    }
+    return &thread_rng;
+}
+
+// the next 64 random bits of the calling thread
+//
+// A solve sets a generator of its own seeded from its context, and the sub QUBOs solved at the
+// same time on different threads each one of theirs, so every solve draws a reproducible
+// sequence whatever else runs in the process.
+uint64_t solver_rand64(void) { return rng_next(current_rng()); }
+
+// a random integer from 0 to n - 1, for n > 0
+//
+// The high half of n times a 32 bit random number (Lemire), retried for the few low halves that
+// would make some results more likely than others, so there is no division in the common case.
+uint32_t solver_rand_below(uint32_t n) {
+    solver_rng_t *rng = current_rng();
+    uint64_t m = (rng_next(rng) >> 32) * (uint64_t)n;
+    if ((uint32_t)m < n) {
+        const uint32_t threshold = (0u - n) % n;
+        while ((uint32_t)m < threshold) m = (rng_next(rng) >> 32) * (uint64_t)n;
+    }
+    return (uint32_t)(m >> 32);
+}
+
+// draw the random numbers of the calling thread from *rng, or its own generator for NULL
+//
+// @returns the generator set before, to be set back when done with rng
+solver_rng_t *solver_rand_stream(solver_rng_t *rng) {
+    solver_rng_t *previous = rand_stream;
+    rand_stream = rng;
+    return previous;
+}
+
+// seconds of a monotonic wall clock, what the deadline of a solve is measured in
+double solver_wall_seconds(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// this randomly sets the bit vector to 1 or 0, 64 bits a draw
 void randomize_solution(int8_t *solution, int nbits) {
-    for (int i = 0; i < nbits; i++) {
-        solution[i] = rand() % 2;
+    for (int i = 0; i < nbits; i += 64) {
+        uint64_t bits = solver_rand64();
+        for (int j = i; j < MIN(i + 64, nbits); j++, bits >>= 1) solution[j] = (int8_t)(bits & 1);
     }
 }
 
 // this circular rotates of the bit vector 1,2,3 or 4 positions
 void rotate_solution(int8_t *solution, int nbits) {
-    int rotate=1+rand()%4;
+    int rotate=1+solver_rand_below(4);
     for (int i = 0; i < nbits-rotate; i++) {
         solution[i] = solution[i+rotate];
     }
@@ -67,68 +382,59 @@ void rotate_solution(int8_t *solution, int nbits) {
 }
 // this randomly flips the bit vector to 1 or 0, favoring turning 0s to 1s
 void flip_solution(int8_t *solution, int nbits) {
-    for (int i = 0; i < nbits; i++) {
-        if ( solution [i] == 1 && rand() %2 == 1 ) {
-            solution [ i] = 0;
-        }else {
-            solution [ i] = 1;
-        }
+    for (int i = 0; i < nbits; i += 64) {
+        uint64_t bits = solver_rand64();
+        for (int j = i; j < MIN(i + 64, nbits); j++, bits >>= 1) solution[j] = !(solution[j] == 1 && (bits & 1));
     }
 }
 // this randomly sets the bit vector to 1 or 0, with index
 void randomize_solution_by_index(int8_t *solution, int nbits, int *indices) {
-    for (int i = 0; i < nbits; i++) {
-        solution[indices[i]] = rand() % 2;
+    for (int i = 0; i < nbits; i += 64) {
+        uint64_t bits = solver_rand64();
+        for (int j = i; j < MIN(i + 64, nbits); j++, bits >>= 1) solution[indices[j]] = (int8_t)(bits & 1);
     }
 }
 // this flips the bit vector to 1 or 0, with index, favoring turning 0s to 1s
 void flip_solution_by_index(int8_t *solution, int nbits, int *indices) {
-    for (int i = 0; i < nbits; i++) {
-        if ( solution [indices[i]] == 1 && rand() %2 == 1 ) {
-            solution [ indices [i]] = 0;
-        }else {
-            solution [ indices [i]] = 1;
+    for (int i = 0; i < nbits; i += 64) {
+        uint64_t bits = solver_rand64();
+        for (int j = i; j < MIN(i + 64, nbits); j++, bits >>= 1) {
+            solution[indices[j]] = !(solution[indices[j]] == 1 && (bits & 1));
         }
     }
 }
 // this randomly sets the bit vector to 1 or 0, with similar population counts
 void randomize_pop_solution(int8_t *solution, int nbits) {
-    double pop_ratio;
-    int pop = 0, pop_ran = 0;
+    int pop = 0;
     for (int i = 0; i < nbits; i++) {
         pop += solution[i];
     }
-    pop_ratio = (double)((double)pop / (double)nbits);
-    pop_ran = (int)((double)RAND_MAX * pop_ratio);
-
-    for (int i = 0; i < nbits; i++) {
-        solution[i] = (rand() < pop_ran) ? 1 : 0;
+    // a 32 bit draw below pop / nbits of 2^32, two draws from each 64 bits
+    const uint64_t pop_ran = (uint64_t)(4294967296.0 * ((double)pop / (double)nbits));
+    uint64_t bits = 0;
+    for (int i = 0; i < nbits; i++, bits >>= 32) {
+        if ((i & 1) == 0) bits = solver_rand64();
+        solution[i] = ((bits & 0xffffffffULL) < pop_ran) ? 1 : 0;
     }
 }
 // this randomly sets the bit vector to 1 or 0, with similar population counts with index
 void randomize_pop_solution_by_index(int8_t *solution, int nbits, int *indices) {
-    double pop_ratio;
-    int pop = 0, pop_ran = 0;
+    int pop = 0;
     for (int i = 0; i < nbits; i++) {
         pop += solution[indices[i]];
     }
-    pop_ratio = (double)((double)pop / (double)nbits);
-    pop_ran = (int)((double)RAND_MAX * pop_ratio);
-
-    for (int i = 0; i < nbits; i++) {
-        solution[indices[i]] = (rand() < pop_ran) ? 1 : 0;
+    const uint64_t pop_ran = (uint64_t)(4294967296.0 * ((double)pop / (double)nbits));
+    uint64_t bits = 0;
+    for (int i = 0; i < nbits; i++, bits >>= 32) {
+        if ((i & 1) == 0) bits = solver_rand64();
+        solution[indices[i]] = ((bits & 0xffffffffULL) < pop_ran) ? 1 : 0;
     }
 }
 // shuffle the index vector using Durstenfeld's version of the Fisher-Yates
 // shuffle algorithm.  Take care to avoid bias
 void shuffle_index(int *indices, int length) {
     for (int i = length - 1; i > 0; i--) {
-        int max_usable_rand = (RAND_MAX / (i + 1)) * (i + 1) - 1;  // integer div
-        int j = 0;
-        do {
-            j = rand();
-        } while (j > max_usable_rand);
-        j %= (i + 1);
+        int j = (int)solver_rand_below((uint32_t)i + 1);
         if (j != i) {
             // swap values
             int tmp = indices[i];
@@ -139,96 +445,99 @@ void shuffle_index(int *indices, int length) {
 }
 
 //  print out the bit vector as row and column, surrounding the Qubo in triangular form  used in the -w option
-void print_solution_and_qubo(int8_t *solution, int maxNodes, double **qubo) {
-    double sign = findMax_ ? 1.0 : -1.0;
+void print_solution_and_qubo(const qbsolv_context_t *ctx, int8_t *solution, int maxNodes, double **qubo) {
+    FILE *out = ctx->out;
+    double sign = ctx->find_max ? 1.0 : -1.0;
 
-    fprintf(outFile_, "ij, ");
-    for (int i = 0; i < maxNodes; i++) fprintf(outFile_, ",%d", i);
-    fprintf(outFile_, "\n");
+    fprintf(out, "ij, ");
+    for (int i = 0; i < maxNodes; i++) fprintf(out, ",%d", i);
+    fprintf(out, "\n");
 
-    fprintf(outFile_, "Q,");
-    for (int i = 0; i < maxNodes; i++) fprintf(outFile_, ",%d", solution[i]);
-    fprintf(outFile_, "\n");
+    fprintf(out, "Q,");
+    for (int i = 0; i < maxNodes; i++) fprintf(out, ",%d", solution[i]);
+    fprintf(out, "\n");
 
     for (int i = 0; i < maxNodes; i++) {
-        fprintf(outFile_, "%d,%d,", i, solution[i]);
-        for (int j = 0; j < i; j++) fprintf(outFile_, ",");
+        fprintf(out, "%d,%d,", i, solution[i]);
+        for (int j = 0; j < i; j++) fprintf(out, ",");
         for (int j = i; j < maxNodes; j++) {
             if (qubo[i][j] != 0.0) {
-                fprintf(outFile_, "%6.4lf,", (qubo[i][j] * sign));
+                fprintf(out, "%6.4lf,", (qubo[i][j] * sign));
             } else {
-                fprintf(outFile_, ",");
+                fprintf(out, ",");
             }
         }
-        fprintf(outFile_, "\n");
+        fprintf(out, "\n");
     }
 
     /*  print out the bit vector as row and column, surrounding the
      *  Qubo where both the row and col bit is set in triangular form */
-    fprintf(outFile_, "  Values that have a Q of 1 ");
+    fprintf(out, "  Values that have a Q of 1 ");
 
-    fprintf(outFile_, "ij, ");
-    for (int i = 0; i < maxNodes; i++) fprintf(outFile_, ",%d", i);
-    fprintf(outFile_, "\n");
+    fprintf(out, "ij, ");
+    for (int i = 0; i < maxNodes; i++) fprintf(out, ",%d", i);
+    fprintf(out, "\n");
 
-    fprintf(outFile_, "Q,");
-    for (int i = 0; i < maxNodes; i++) fprintf(outFile_, ",%d", solution[i]);
-    fprintf(outFile_, "\n");
+    fprintf(out, "Q,");
+    for (int i = 0; i < maxNodes; i++) fprintf(out, ",%d", solution[i]);
+    fprintf(out, "\n");
 
     for (int i = 0; i < maxNodes; i++) {
-        fprintf(outFile_, "%d,%d,", i, solution[i]);
-        for (int j = 0; j < i; j++) fprintf(outFile_, ",");
+        fprintf(out, "%d,%d,", i, solution[i]);
+        for (int j = 0; j < i; j++) fprintf(out, ",");
         for (int j = i; j < maxNodes; j++) {
             if (((double)solution[i] * solution[j]) * qubo[i][j] != 0) {
-                fprintf(outFile_, "%6.4lf,", qubo[i][j] * sign * solution[i] * solution[j]);
+                fprintf(out, "%6.4lf,", qubo[i][j] * sign * solution[i] * solution[j]);
             } else {
-                fprintf(outFile_, ",");
+                fprintf(out, ",");
             }
         }
-        fprintf(outFile_, "\n");
+        fprintf(out, "\n");
     }
 }
 //  This routine prints without \n the options for the run
 //
-void print_opts(int maxNodes, parameters_t *param) {
-    fprintf(outFile_, "%d bits, ", maxNodes);
+void print_opts(const qbsolv_context_t *ctx, int maxNodes, parameters_t *param) {
+    FILE *out = ctx->out;
+    fprintf(out, "%d bits, ", maxNodes);
     // if ( UseDwave_ ) {
-    //     fprintf(outFile_,"Quantum solver,");
+    //     fprintf(out,"Quantum solver,");
     // }else {
-    //     fprintf(outFile_,"Classical tabu solver,");
+    //     fprintf(out,"Classical tabu solver,");
     // }
-    if (findMax_) {
-        fprintf(outFile_, " find Max,");
+    if (ctx->find_max) {
+        fprintf(out, " find Max,");
     } else {
-        fprintf(outFile_, " find Min,");
+        fprintf(out, " find Min,");
     }
-    fprintf(outFile_, " SubMatrix= %d,", param->sub_size);
-    fprintf(outFile_, " -a %s,", algo_);
-    if (TargetSet_) fprintf(outFile_, " Target of %8.5f,", Target_);
-    fprintf(outFile_, " timeout=%9.1f sec\n", Time_);
+    fprintf(out, " SubMatrix= %d,", param->sub_size);
+    fprintf(out, " -a %s,", ctx->algo);
+    if (ctx->target_set) fprintf(out, " Target of %8.5f,", ctx->target);
+    fprintf(out, " timeout=%9.1f sec\n", ctx->timeout);
 }
 
 //  This routine performs the standard output for qbsolv
 //
-void print_output(int maxNodes, int8_t *solution, long numPartCalls, double energy, double seconds,
-                  parameters_t *param) {
+void print_output(qbsolv_context_t *ctx, int maxNodes, int8_t *solution, long numPartCalls, double energy,
+                  double seconds, parameters_t *param) {
+    FILE *out = ctx->out;
     int i;
 
-    if (numsolOut_ > 0) {
-        print_opts(maxNodes, param);
+    if (ctx->num_outputs > 0) {
+        print_opts(ctx, maxNodes, param);
     }
-    numsolOut_++;
+    ctx->num_outputs++;
     for (i = 0; i < maxNodes; i++) {
-        fprintf(outFile_, "%d", solution[i]);
-    }
-    fprintf(outFile_, "\n");
-    fprintf(outFile_, "%8.5f Energy of solution\n", energy);
-    fprintf(outFile_, "%ld Number of Partitioned calls, %d output sample \n", numPartCalls, numsolOut_);
-    fprintf(outFile_, "%8.5f seconds of classic cpu time", seconds);
-    if (TargetSet_) {
-        fprintf(outFile_, " ,Target of %8.5f\n", Target_);
+        fprintf(out, "%d", solution[i]);
+    }
+    fprintf(out, "\n");
+    fprintf(out, "%8.5f Energy of solution\n", energy);
+    fprintf(out, "%ld Number of Partitioned calls, %d output sample \n", numPartCalls, ctx->num_outputs);
+    fprintf(out, "%8.5f seconds of wall clock time", seconds);
+    if (ctx->target_set) {
+        fprintf(out, " ,Target of %8.5f\n", ctx->target);
     } else {
-        fprintf(outFile_, "\n");
+        fprintf(out, "\n");
     }
 }
 
@@ -279,18 +588,26 @@ void quick_sort_iterative_index(double val[], int arr[], int n, int *stack) {
         // in sorted array
         int p = partition(val, arr, l, h);
 
-        // If there are elements on left side of pivot,
-        // then push left side to stack
-        if (p - 1 > l) {
-            stack[++top] = l;
-            stack[++top] = p - 1;
-        }
-
-        // If there are elements on right side of pivot,
-        // then push right side to stack
-        if (p + 1 < h) {
-            stack[++top] = p + 1;
-            stack[++top] = h;
+        // Push the larger side first so the smaller side is popped next, that keeps
+        // at most one pending range per halving on the stack (SORT_STACK_SIZE)
+        if (p - l > h - p) {
+            if (p - 1 > l) {
+                stack[++top] = l;
+                stack[++top] = p - 1;
+            }
+            if (p + 1 < h) {
+                stack[++top] = p + 1;
+                stack[++top] = h;
+            }
+        } else {
+            if (p + 1 < h) {
+                stack[++top] = p + 1;
+                stack[++top] = h;
+            }
+            if (p - 1 > l) {
+                stack[++top] = l;
+                stack[++top] = p - 1;
+            }
         }
     }
 }
@@ -330,16 +647,11 @@ int val_index_pos(int *index, double *val, int n, double compare) {
 //
 void val_index_sort(int *index, double *val, int n) {
     int i;
-    int *stack;  // temp space = n + 1
-    // Create an auxiliary stack
-    if ((GETMEM(stack, int, (n + 1))) == NULL) {
-        BADMALLOC
-    }
+    int stack[SORT_STACK_SIZE];
 
     for (i = 0; i < n; i++) index[i] = i;
     shuffle_index(index, n);
     quick_sort_iterative_index(val, index, n, stack);
-    free(stack);
     // check code:
     // for (i=0;i<n-1;i++) { if (val[index[i]]<val[index[i+1]]) { DL; exit(9); } }
     return;
@@ -347,16 +659,11 @@ void val_index_sort(int *index, double *val, int n) {
 
 void val_index_sort_ns(int *index, double *val, int n) {
     int i;
-    int *stack;  // temp space = n + 1
-    // Create an auxiliary stack
-    if ((GETMEM(stack, int, (n + 1))) == NULL) {
-        BADMALLOC
-    }
+    int stack[SORT_STACK_SIZE];
 
     // Assure that the index array covers val[] completely
     for (i = 0; i < n; i++) index[i] = i;
     quick_sort_iterative_index(val, index, n, stack);
-    free(stack);
     // check code:
     // for (i=0;i<n-1;i++) { if (val[index[i]]<val[index[i+1]]) { DL; exit(9); } }
     return;
@@ -499,6 +806,224 @@ int mul_index_solution_diff(int8_t **solution, int num_solutions, int nbits, int
     }
     return ndiff;
 }
+// create a pool of rows bit-packed solutions of nbits variables, all zero
+//@param  rows number of solutions the pool holds, one more than the solution_list entries
+//        compared by manage_solutions, the last row is its scratch space
+//@param  nbits = length of the solution vectors
+struct solution_pool *solution_pool_create(int rows, int nbits) {
+    struct solution_pool *pool;
+    if (GETMEM(pool, struct solution_pool, 1) == NULL) BADMALLOC
+    pool->nbits = nbits;
+    pool->words = SOLUTION_WORDS(nbits);
+    pool->bits = (uint64_t **)malloc2D(rows, pool->words, sizeof(uint64_t));
+    if (GETMEM(pool->hash, uint64_t, rows) == NULL) BADMALLOC
+    for (int i = 0; i < rows; i++) {
+        for (int w = 0; w < pool->words; w++) pool->bits[i][w] = 0;
+        pool->hash[i] = 0;
+    }
+    return pool;
+}
+
+// Empty the first rows of a pool for solutions of nbits bits, so one pool serves QUBO after QUBO
+//
+// @param pool a pool from solution_pool_create
+// @param rows the rows to empty, at most the rows it was created with
+// @param nbits the length of the solutions, at most the nbits it was created with
+void solution_pool_reset(struct solution_pool *pool, int rows, int nbits) {
+    pool->nbits = nbits;
+    pool->words = SOLUTION_WORDS(nbits);
+    for (int i = 0; i < rows; i++) {
+        for (int w = 0; w < pool->words; w++) pool->bits[i][w] = 0;
+        pool->hash[i] = 0;
+    }
+}
+
+void solution_pool_free(struct solution_pool *pool) {
+    if (pool == NULL) return;
+    free(pool->bits);
+    free(pool->hash);
+    free(pool);
+}
+
+// copy row from of the pool, bits and hash, over row to
+static void pool_copy_row(struct solution_pool *pool, int to, int from) {
+    for (int w = 0; w < pool->words; w++) pool->bits[to][w] = pool->bits[from][w];
+    pool->hash[to] = pool->hash[from];
+}
+
+// 64 bit finalizer of splitmix64, spreads every input bit over the whole word
+static uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// pack solution into row of the pool and update its hash
+void solution_pool_store(struct solution_pool *pool, int row, const int8_t *solution) {
+    uint64_t *bits = pool->bits[row];
+    uint64_t hash = (uint64_t)pool->nbits;
+    for (int w = 0; w < pool->words; w++) {
+        int start = w * 64;
+        int end = MIN(start + 64, pool->nbits);
+        uint64_t word = 0;
+        for (int i = start; i < end; i++) word |= (uint64_t)(solution[i] != 0) << (i - start);
+        bits[w] = word;
+        hash = mix64(hash ^ word);
+    }
+    pool->hash[row] = hash;
+}
+
+static int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1) count++;
+    return count;
+#endif
+}
+
+static int ctz64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int count = 0;
+    for (; !(x & 1); x >>= 1) count++;
+    return count;
+#endif
+}
+
+// number of variables that differ between two bit-packed solutions, their Hamming distance
+int packed_solution_distance(const uint64_t *bits_a, const uint64_t *bits_b, int words) {
+    int distance = 0;
+    for (int w = 0; w < words; w++) distance += popcount64(bits_a[w] ^ bits_b[w]);
+    return distance;
+}
+
+//  same as mul_index_solution_diff, on the bit-packed copies of the solutions in pool
+//  with delta_bits == 0 a variable differs when the OR and the AND of its column disagree,
+//  which is found for 64 variables at a time, other values count the column bit by bit
+//@param  pool bit-packed copies of the solutions
+//@param  num_solutions number of solutions in solution
+//@param  index is integer index vector of solution differences, will be ordered
+//@param  delta_bits is integer to compare with to establish backbone in index, see mul_index_solution_diff
+//@param  sol_index is integer index vector of which solutions (rows of the pool) to look at
+//  ndiff number of differences between solution(s),, returned value
+//
+int pool_index_solution_diff(const struct solution_pool *pool, int num_solutions, int *index, int delta_bits,
+                             int *sol_index) {
+    int ndiff = 0;
+    for (int w = 0; w < pool->words; w++) {
+        int start = w * 64;
+        int end = MIN(start + 64, pool->nbits);
+        uint64_t differ = 0;
+
+        if (delta_bits == 0) {
+            uint64_t any = 0, all = ~(uint64_t)0;
+            for (int j = 0; j < num_solutions; j++) {
+                uint64_t word = pool->bits[sol_index[j]][w];
+                any |= word;
+                all &= word;
+            }
+            if (num_solutions > 0) differ = any & ~all;
+        } else {
+            for (int i = start; i < end; i++) {
+                int sum_bits = 0;
+                for (int j = 0; j < num_solutions; j++) {
+                    sum_bits += (int)((pool->bits[sol_index[j]][w] >> (i - start)) & 1);
+                }
+                if (sum_bits > (int)((num_solutions + 1) / 2) - 1) sum_bits = num_solutions - sum_bits;
+                if (sum_bits > delta_bits) differ |= (uint64_t)1 << (i - start);
+            }
+        }
+
+        for (; differ; differ &= differ - 1) {
+            index[ndiff++] = start + ctz64(differ);
+        }
+    }
+    for (int i = ndiff; i < pool->nbits; i++) {  // clean out the rest of the vector
+        index[i] = 0;
+    }
+    return ndiff;
+}
+
+// Create a move tree of size variables
+//
+// @param size the number of variables
+// @returns the tree, with no variable masked; move_tree_build must be called before it is used
+struct move_tree *move_tree_create(int size) {
+    struct move_tree *tree;
+    if (GETMEM(tree, struct move_tree, 1) == NULL) BADMALLOC
+    tree->size = size;
+    tree->leaves = 1;
+    while (tree->leaves < size) tree->leaves *= 2;
+    tree->masked_count = 0;
+    tree->cost = NULL;
+    if (GETMEM(tree->masked, int8_t, size) == NULL) BADMALLOC
+    if (GETMEM(tree->winner, int, 2 * tree->leaves) == NULL) BADMALLOC
+    // room for a tabu tenure of up to MAX(size + 1, 35), the largest tabu_search uses
+    if (GETMEM(tree->history, int, MAX(size, 64) + 3) == NULL) BADMALLOC
+    for (int i = 0; i < size; i++) tree->masked[i] = 0;
+    for (int i = 0; i < 2 * tree->leaves; i++) tree->winner[i] = -1;
+    return tree;
+}
+
+void move_tree_free(struct move_tree *tree) {
+    if (tree == NULL) return;
+    free(tree->masked);
+    free(tree->winner);
+    free(tree->history);
+    free(tree);
+}
+
+// the better of two tree entries: the larger cost, the left one on ties, any variable over none
+static inline int move_tree_match(const struct move_tree *tree, int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+    return tree->cost[right] > tree->cost[left] ? right : left;
+}
+
+// Rebuild the tree from the costs, O(n)
+//
+// @param tree the tree
+// @param cost the flip costs of the tree->size variables, kept by the tree for later updates
+void move_tree_build(struct move_tree *tree, const double *cost) {
+    const int leaves = tree->leaves;
+    tree->cost = cost;
+    for (int i = 0; i < tree->size; i++) tree->winner[leaves + i] = tree->masked[i] ? -1 : i;
+    for (int node = leaves - 1; node > 0; node--)
+        tree->winner[node] = move_tree_match(tree, tree->winner[2 * node], tree->winner[2 * node + 1]);
+}
+
+// Replay the matches on the path from the leaf of variable i to the root, O(log n)
+//
+// @param tree the tree
+// @param i the variable whose cost or mask changed
+void move_tree_update(struct move_tree *tree, int i) {
+    int node = tree->leaves + i;
+    tree->winner[node] = tree->masked[i] ? -1 : i;
+    for (node /= 2; node > 0; node /= 2)
+        tree->winner[node] = move_tree_match(tree, tree->winner[2 * node], tree->winner[2 * node + 1]);
+}
+
+// Mask or unmask a variable, O(log n)
+//
+// @param tree the tree
+// @param i the variable
+// @param masked true to take i out of the candidates
+void move_tree_set_masked(struct move_tree *tree, int i, bool masked) {
+    if (tree->masked[i] == (int8_t)masked) return;
+    tree->masked[i] = masked;
+    tree->masked_count += masked ? 1 : -1;
+    move_tree_update(tree, i);
+}
+
+// The unmasked variable with the largest cost, O(1)
+//
+// @param tree the tree
+// @returns the variable, or -1 if every variable is masked
+int move_tree_best(const struct move_tree *tree) { return tree->winner[1]; }
+
 //  print out each solution in index order per qbsolv output format
 //      Return the number of values in the index vector
 //@param  solution[num_solutions][nbits] = bit vector solution
@@ -509,23 +1034,24 @@ int mul_index_solution_diff(int8_t **solution, int num_solutions, int nbits, int
 //      small to large
 //  ndiff number of differences between solution(s),, returned value
 //
-void print_solutions(int8_t **solution, double *energy_list, int *solutions_counts, int num_solutions, int nbits,
-                     int *index) {
+void print_solutions(const qbsolv_context_t *ctx, int8_t **solution, double *energy_list, int *solutions_counts,
+                     int num_solutions, int nbits, int *index) {
+    FILE *out = ctx->out;
     int i, j, k;
     double delta, energy, top_energy;
-    fprintf(outFile_, "delta energy  Energy of solution\tnfound\tindex\t i\t");
-    fprintf(outFile_, " number of unique solutions %d\n", num_solutions);
+    fprintf(out, "delta energy  Energy of solution\tnfound\tindex\t i\t");
+    fprintf(out, " number of unique solutions %d\n", num_solutions);
     k = index[0];
     top_energy = energy_list[k];
     for (i = num_solutions - 1; i > -1; i--) {
         k = index[i];
         energy = energy_list[k];
         delta = top_energy - energy_list[k];
-        fprintf(outFile_, "%8.5f \t  %8.5f \t %d \t %d \t %d \t", delta, energy, solutions_counts[k], k, i);
+        fprintf(out, "%8.5f \t  %8.5f \t %d \t %d \t %d \t", delta, energy, solutions_counts[k], k, i);
         for (j = 0; j < nbits; j++) {
-            fprintf(outFile_, "%d", solution[k][j]);
+            fprintf(out, "%d", solution[k][j]);
         }
-        fprintf(outFile_, "\n");
+        fprintf(out, "\n");
     }
     return;
 }
@@ -537,14 +1063,19 @@ void print_solutions(int8_t **solution, double *energy_list, int *solutions_coun
 //@param list_order is the order of solution_list based upon energies
 //@param nMax is size of the arrays (solution_list, energy_list...)
 //@param num_nq_solutions is the number of unique solutions in the solution_list...)
+//@param pool bit-packed copies of solution_list with nMax + 1 rows, kept in step with it, or NULL
+//       to compare the solutions byte by byte
 // if solution_now is unique, and is better than or equal to the worst solution add it to solution_list
 // if solution_now is not unique ( equal energy )  increment number of times found
-struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_list, double energy_now,
-                                     double *energy_list, int *solution_counts, int *list_order, int nMax, int nbits,
-                                     int *num_nq_solutions) {
+struct sol_man_rslt manage_solutions(const qbsolv_context_t *ctx, int8_t *solution_now, int8_t **solution_list,
+                                     double energy_now, double *energy_list, int *solution_counts, int *list_order,
+                                     int nMax, int nbits, int *num_nq_solutions, struct solution_pool *pool) {
     struct sol_man_rslt result;
     val_index_sort_ns(list_order, energy_list, nMax);  // index array of sorted energies
 
+    // pack solution_now into the spare last row, entries are stored by copying it over
+    if (pool != NULL) solution_pool_store(pool, nMax, solution_now);
+
     // printf(" %d ",(*num_nq_solutions));
     // new high value,
     if (energy_now > energy_list[list_order[0]]) {
@@ -555,6 +1086,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
         for (int i = 0; i < nbits; i++) {
             solution_list[empty_row][i] = solution_now[i];
         }
+        if (pool != NULL) pool_copy_row(pool, empty_row, nMax);
         (*num_nq_solutions) = MIN((*num_nq_solutions) + 1, nMax);
 
         energy_list[empty_row] = energy_now;
@@ -567,7 +1099,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
         result.code = NEW_HIGH_ENERGY_UNIQUE_SOL;
         result.count = 1;
         result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-        if (Verbose_ > 3) {
+        if (ctx->verbose > 3) {
             printf(" NEW_HIGH_ENERGY_UNIQUE_SOL   %lf %d %d\n", energy_now, result.count, result.pos);
         }
         return result;
@@ -579,7 +1111,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
         result.code = NOTHING;
         result.count = 0;
         result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-        if (Verbose_ > 3) {
+        if (ctx->verbose > 3) {
             printf(" NOTHING                      %lf %d %d\n", energy_now, result.count, result.pos);
         }
         return result;
@@ -593,7 +1125,15 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
 
             // look thru all Q's of common energy (they are ordered)
             while (j < nMax && energy_list[list_order[j]] == energy_now) {
-                if (is_array_equal(solution_list[list_order[j]], solution_now, nbits)) {
+                bool same;
+                if (pool != NULL) {
+                    int row = list_order[j];
+                    same = pool->hash[row] == pool->hash[nMax] &&
+                           packed_solution_distance(pool->bits[row], pool->bits[nMax], pool->words) == 0;
+                } else {
+                    same = is_array_equal(solution_list[list_order[j]], solution_now, nbits);
+                }
+                if (same) {
                     // simply mark this Q and energy as a duplicate find
                     solution_counts[list_order[j]]++;
 
@@ -602,7 +1142,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
                         result.code = DUPLICATE_HIGHEST_ENERGY;
                         result.count = solution_counts[list_order[0]];
                         result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-                        if (Verbose_ > 3) {
+                        if (ctx->verbose > 3) {
                             printf(" DUPLICATE_HIGHEST_ENERGY     %lf %d %d\n", energy_now, result.count, result.pos);
                         }
                         return result;
@@ -611,7 +1151,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
                         result.code = DUPLICATE_ENERGY;
                         result.count = solution_counts[list_order[j]];
                         result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-                        if (Verbose_ > 3) {
+                        if (ctx->verbose > 3) {
                             printf(" DUPLICATE_ENERGY             %lf %d %d\n", energy_now, result.count, result.pos);
                         }
                         return result;
@@ -629,6 +1169,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
             for (int i = 0; i < nbits; i++) {
                 solution_list[j][i] = solution_now[i];
             }
+            if (pool != NULL) pool_copy_row(pool, j, nMax);
             (*num_nq_solutions) = MIN((*num_nq_solutions) + 1, nMax);
 
             // Create index array of sorted energies
@@ -638,7 +1179,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
                 // duplicate highest energy unique Q and equal to best energy
                 result.code = DUPLICATE_HIGHEST_ENERGY;
                 result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-                if (Verbose_ > 3) {
+                if (ctx->verbose > 3) {
                     printf(" DUPLICATE_ENERGY             %lf %d %d\n", energy_now, result.count, result.pos);
                 }
                 return result;
@@ -646,7 +1187,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
                 // duplicate energy matching older lower energy Q
                 result.code = DUPLICATE_ENERGY_UNIQUE_SOL;
                 result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-                if (Verbose_ > 3) {
+                if (ctx->verbose > 3) {
                     printf(" DUPLICATE_ENERGY_UNIQUE_SOL  %lf %d %d\n", energy_now, result.count, result.pos);
                 }
                 return result;
@@ -663,6 +1204,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
             for (int i = 0; i < nbits; i++) {
                 solution_list[j][i] = solution_now[i];
             }
+            if (pool != NULL) pool_copy_row(pool, j, nMax);
             (*num_nq_solutions) = MIN((*num_nq_solutions) + 1, nMax);
 
             // create index array of sorted energies
@@ -670,7 +1212,7 @@ struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_lis
             result.code = NEW_ENERGY_UNIQUE_SOL;
             result.count = solution_counts[list_order[j]];
             result.pos = val_index_pos(list_order, energy_list, nMax, energy_now);
-            if (Verbose_ > 3) {
+            if (ctx->verbose > 3) {
                 printf(" NEW_ENERGY_UNIQUE_SOL  %lf %d %d\n", energy_now, result.count, result.pos);
             }
             return result;
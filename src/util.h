@@ -22,8 +22,9 @@
 extern "C" {
 #endif
 
-// Forward declare parameter type
+// Forward declare parameter and context types
 typedef struct parameters_t parameters_t;
+typedef struct qbsolv_context_t qbsolv_context_t;
 
 enum                                // of codes for sol_rslt.code
 { NOTHING = 0,                      // nothing new, do nothing
@@ -40,9 +41,81 @@ struct sol_man_rslt {
     int pos;
 };
 
+// number of 64 bit words of a bit-packed solution of nbits variables
+#define SOLUTION_WORDS(nbits) (((nbits) + 63) / 64)
+
+// Bit-packed copies of the solutions kept in a solution_list, 64 variables a word, with a
+// 64 bit hash of every entry. manage_solutions keeps it in step with solution_list so that
+// duplicate checks and the differences between solutions work a word at a time.
+struct solution_pool {
+    int nbits;
+    int words;        // SOLUTION_WORDS(nbits)
+    uint64_t **bits;  // [rows][words], bit i of a solution is bit i % 64 of word i / 64
+    uint64_t *hash;   // [rows]
+};
+
+// A tournament tree over the flip costs of the variables that are not tabu. The root is the
+// variable with the largest cost, ties going to the lower variable, and changing the cost or the
+// tabu state of one variable is O(log n), so tabu_search can pick its move without a full scan.
+struct move_tree {
+    int size;             // number of variables
+    int leaves;           // power of two >= size
+    int masked_count;     // number of masked (tabu) variables
+    int8_t *masked;       // [size], 1 if the variable is not a candidate
+    int *winner;          // [2 * leaves], winner[1] is the root, winner[leaves + i] the leaf of i, -1 for none
+    const double *cost;   // [size], the flip costs, read but never written
+    int *history;         // [MAX(size, 64) + 3], ring of the variables tabu_search masked, to unmask them on expiry
+};
+
+// byte alignment of the rows of malloc2D_aligned and malloc2D_triangular, one cache line
+#define MATRIX_ALIGN 64
+
+// matrix data at least this large is advised to use transparent huge pages
+#define HUGE_PAGE_MIN_BYTES ((uintptr_t)4 << 20)
+
 // create and pointer fill a 2d array of "size"
 void **malloc2D(uint rows, uint cols, uint size);
 
+// create and pointer fill a 2d array of "size" with MATRIX_ALIGN aligned, padded rows
+void **malloc2D_aligned(uint rows, uint cols, uint size);
+
+// create and pointer fill a packed upper triangular 2d array of "size", X[i][j] valid for i <= j
+void **malloc2D_triangular(uint n, uint size);
+
+// copy the upper triangle of a full size x size qubo into its lower triangle
+void symmetrize_qubo(double **qubo, int size);
+
+// create a full, mirrored single precision copy of an upper triangular qubo
+float **float_qubo_create(double **qubo, int size);
+
+// true if every coefficient of an upper triangular qubo is an integer that fits in an int32_t, and
+// so does its negation
+bool qubo_is_integral(double **qubo, int size);
+
+// create a full, mirrored int32_t copy of an upper triangular qubo with integral coefficients
+int32_t **integer_qubo_create(double **qubo, int size);
+
+// the state of a xoshiro256** generator, the random numbers of a solve or of one of its threads
+typedef struct solver_rng_t {
+    uint64_t s[4];
+} solver_rng_t;
+
+// set rng to the stream of seed, any seed is valid
+void solver_rng_seed(solver_rng_t *rng, uint64_t seed);
+
+// the next 64 random bits of the calling thread's generator
+uint64_t solver_rand64(void);
+
+// a random integer from 0 to n - 1 of the calling thread's generator, without bias, n > 0
+uint32_t solver_rand_below(uint32_t n);
+
+// draw the random numbers of the calling thread from *rng until set again, NULL goes back to
+// the thread's own generator; returns the generator it replaces
+solver_rng_t *solver_rand_stream(solver_rng_t *rng);
+
+// seconds of a monotonic wall clock, what the deadline of a solve is measured in
+double solver_wall_seconds(void);
+
 // this randomly sets the bit vector to 1 or 0
 void randomize_solution(int8_t *solution, int nbits);
 
@@ -71,18 +144,22 @@ void shuffle_index(int *indices, int length);
 void shuffle_solution(int8_t *solution, int length);
 
 //  print out the bit vector as row and column, surrounding the Qubo in triangular form  used in the -w option
-void print_solution_and_qubo(int8_t *solution, int maxNodes, double **qubo);
+void print_solution_and_qubo(const qbsolv_context_t *ctx, int8_t *solution, int maxNodes, double **qubo);
 
 //  This routine prints without \n the options for the run
-void print_opts(int maxNodes, parameters_t *param);
+void print_opts(const qbsolv_context_t *ctx, int maxNodes, parameters_t *param);
 
 //  This routine performs the standard output for qbsolv
-void print_output(int maxNodes, int8_t *solution, long numPartCalls, double energy, double seconds,
-                  parameters_t *param);
+void print_output(qbsolv_context_t *ctx, int maxNodes, int8_t *solution, long numPartCalls, double energy,
+                  double seconds, parameters_t *param);
+
+// entries of the stack quick_sort_iterative_index needs for any array with an int size
+#define SORT_STACK_SIZE (2 * (8 * sizeof(int) + 1))
 
 /* val[] --> Array to be sorted,
    arr[] --> index to point to order from largest to smallest
-   n     --> number of elements in arrays */
+   n     --> number of elements in arrays
+   stack --> SORT_STACK_SIZE entries of scratch */
 void quick_sort_iterative_index(double val[], int arr[], int n, int *stack);
 
 // routine to check the sort on index'ed sort
@@ -115,13 +192,48 @@ void solution_population(int8_t *popularSol, int8_t **solution, int num_solution
 int mul_index_solution_diff(int8_t **solution, int num_solutions, int nbits, int *index, int delta_bits,
                             int *sol_index);
 
+// create a pool of rows bit-packed solutions of nbits variables, released with solution_pool_free
+struct solution_pool *solution_pool_create(int rows, int nbits);
+
+void solution_pool_free(struct solution_pool *pool);
+
+// empty the first rows of a pool for solutions of nbits bits, at most the nbits it was created with
+void solution_pool_reset(struct solution_pool *pool, int rows, int nbits);
+
+// pack solution into row of the pool and update its hash
+void solution_pool_store(struct solution_pool *pool, int row, const int8_t *solution);
+
+// number of variables that differ between two bit-packed solutions
+int packed_solution_distance(const uint64_t *bits_a, const uint64_t *bits_b, int words);
+
+//  same as mul_index_solution_diff, on the bit-packed copies of the solutions
+int pool_index_solution_diff(const struct solution_pool *pool, int num_solutions, int *index, int delta_bits,
+                             int *sol_index);
+
+// create a move tree of size variables, none masked, released with move_tree_free
+struct move_tree *move_tree_create(int size);
+
+void move_tree_free(struct move_tree *tree);
+
+// rebuild the whole tree from cost, keeping the masks, O(n)
+void move_tree_build(struct move_tree *tree, const double *cost);
+
+// recompute the path of variable i after its cost changed, O(log n)
+void move_tree_update(struct move_tree *tree, int i);
+
+// mask or unmask variable i, O(log n)
+void move_tree_set_masked(struct move_tree *tree, int i, bool masked);
+
+// the unmasked variable with the largest cost, -1 if every variable is masked
+int move_tree_best(const struct move_tree *tree);
+
 //  print out each solution in index order per qbsolv output format
-void print_solutions(int8_t **solution, double *energy_list, int *solutions_counts, int num_solutions, int nbits,
-                     int *index);
+void print_solutions(const qbsolv_context_t *ctx, int8_t **solution, double *energy_list, int *solutions_counts,
+                     int num_solutions, int nbits, int *index);
 
-struct sol_man_rslt manage_solutions(int8_t *solution_now, int8_t **solution_list, double energy_now,
-                                     double *energy_list, int *solution_counts, int *list_order, int nMax, int nbits,
-                                     int *num_nq_solutions);
+struct sol_man_rslt manage_solutions(const qbsolv_context_t *ctx, int8_t *solution_now, int8_t **solution_list,
+                                     double energy_now, double *energy_list, int *solution_counts, int *list_order,
+                                     int nMax, int nbits, int *num_nq_solutions, struct solution_pool *pool);
 
 // write qubo file to *filename
 void write_qubo(double **qubo, int nMax, const char *filename);
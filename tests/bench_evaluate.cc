@@ -0,0 +1,81 @@
+// Microbenchmark of the evaluate kernels on bqp1000 and bqp2500 sized QUBOs, for every
+// instruction set this CPU supports. Not run as a test, build the bench_evaluate target and
+// run it by hand: bench_evaluate [flips]
+#include "extern.h"
+#include "qbsolv.h"
+#include "simd.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    const int sizes[] = {1000, 2500};
+    long flips = argc > 1 ? atol(argv[1]) : 200000;
+
+    printf("%-8s %6s %10s %12s %12s %12s %12s\n", "kernels", "size", "layout", "ns/flip", "Mflips/s",
+           "us/evaluate", "energy");
+    for (int s = 0; s < 2; s++) {
+        int size = sizes[s];
+        double **dense = (double **)malloc2D_aligned(size, size, sizeof(double));
+        double **symmetric = (double **)malloc2D_aligned(size, size, sizeof(double));
+        randomQubo(size, 1, dense, bqpValues, true);
+        randomQubo(size, 1, symmetric, bqpValues, true);
+        symmetrize_qubo(symmetric, size);
+        float **single = float_qubo_create(dense, size);
+
+        int8_t *solution = (int8_t *)malloc(size);
+        double *flip_cost = (double *)malloc(size * sizeof(double));
+        int *bits = (int *)malloc(flips * sizeof(int));
+        for (long i = 0; i < flips; i++) bits[i] = rand() % size;
+
+        for (int level = SIMD_SCALAR; level <= SIMD_AVX512; level++) {
+            const simd_kernels_t *kernels = simd_kernels_for((simd_level_t)level);
+            if (kernels == NULL) continue;
+
+            for (int layout = 0; layout < 3; layout++) {
+                const double **qubo = (const double **)(layout == 1 ? symmetric : dense);
+                evaluate_kernel full = layout == 1 ? kernels->evaluate_symmetric : kernels->evaluate;
+
+                srand(2);
+                randomize_solution(solution, size);
+                int evaluations = 20;
+                double start = now();
+                double energy = 0.0;
+                for (int i = 0; i < evaluations; i++) energy = full(solution, size, qubo, flip_cost);
+                double evaluate_time = (now() - start) / evaluations;
+
+                start = now();
+                for (long i = 0; i < flips; i++) {
+                    if (layout == 0)
+                        energy = kernels->evaluate_1bit(energy, bits[i], solution, size, qubo, flip_cost);
+                    else if (layout == 1)
+                        energy = kernels->evaluate_1bit_symmetric(energy, bits[i], solution, size, qubo, flip_cost);
+                    else
+                        energy = kernels->evaluate_1bit_float(energy, bits[i], solution, size,
+                                                              (const float **)single, flip_cost);
+                }
+                double flip_time = (now() - start) / flips;
+
+                const char *names[] = {"dense", "symmetric", "float"};
+                printf("%-8s %6d %10s %12.1f %12.2f %12.1f %12.0f\n", kernels->name, size, names[layout],
+                       flip_time * 1e9, 1e-6 / flip_time, evaluate_time * 1e6, energy);
+            }
+        }
+
+        free(bits);
+        free(flip_cost);
+        free(solution);
+        free(single);
+        free(symmetric);
+        free(dense);
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Microbenchmark of reduce and reduce_symmetric against reduce_flip_cost, for sub QUBOs of 47
+// variables picked at random from bqp style QUBOs of a few sizes. Not run as a test, build the
+// bench_reduce target and run it by hand: bench_reduce [reductions]
+#include "extern.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    const int sizes[] = {1000, 2500, 5000};
+    const int sub_size = 47;
+    int reductions = argc > 1 ? atoi(argv[1]) : 2000;
+    if (reductions < 1) {
+        fprintf(stderr, "usage: bench_reduce [reductions], at least 1 reduction\n");
+        return 1;
+    }
+
+    printf("%6s %10s %14s %14s %10s\n", "size", "layout", "reduce us", "flip_cost us", "speedup");
+    for (int s = 0; s < 3; s++) {
+        int size = sizes[s];
+        double **triangular = (double **)malloc2D_triangular(size, sizeof(double));
+        randomQubo(size, 1, triangular, bqpValues, false);
+
+        int8_t *solution = (int8_t *)malloc(size);
+        double *flip_cost = (double *)malloc(size * sizeof(double));
+        int *index = (int *)malloc(size * sizeof(int));
+        int *groups = (int *)malloc((size_t)reductions * sub_size * sizeof(int));
+        double **sub_qubo = (double **)malloc2D_aligned(sub_size, sub_size, sizeof(double));
+        int8_t sub_solution[sub_size];
+
+        // the sub QUBOs of a run are the variables of least flip cost, so any sorted set will do
+        for (int i = 0; i < size; i++) index[i] = i;
+        for (int r = 0; r < reductions; r++) {
+            shuffle_index(index, size);
+            for (int i = 0; i < sub_size; i++) groups[r * sub_size + i] = index[i];
+            index_sort(&groups[r * sub_size], sub_size, true);
+        }
+
+        for (int layout = 0; layout < 2; layout++) {
+            double **symmetric = NULL;
+            qubo_matrix_t qubo = dense_qubo_matrix(triangular, size);
+            if (layout == 1) {
+                symmetric = (double **)malloc2D_aligned(size, size, sizeof(double));
+                for (int i = 0; i < size; i++)
+                    for (int j = i; j < size; j++) symmetric[i][j] = triangular[i][j];
+                symmetrize_qubo(symmetric, size);
+                qubo.layout = QUBO_SYMMETRIC;
+                qubo.dense = symmetric;
+            }
+            randomize_solution(solution, size);
+            qubo_evaluate(solution, &qubo, flip_cost);
+
+            double start = now();
+            for (int r = 0; r < reductions; r++)
+                qubo_reduce(&groups[r * sub_size], &qubo, sub_size, sub_qubo, solution, sub_solution);
+            double reduce_time = (now() - start) / reductions;
+
+            start = now();
+            for (int r = 0; r < reductions; r++)
+                reduce_flip_cost(&groups[r * sub_size], &qubo, sub_size, sub_qubo, solution, sub_solution, flip_cost);
+            double flip_cost_time = (now() - start) / reductions;
+
+            printf("%6d %10s %14.2f %14.2f %9.1fx\n", size, layout == 0 ? "dense" : "symmetric", reduce_time * 1e6,
+                   flip_cost_time * 1e6, reduce_time / flip_cost_time);
+            free(symmetric);
+        }
+
+        free(sub_qubo);
+        free(groups);
+        free(index);
+        free(flip_cost);
+        free(solution);
+        free(triangular);
+    }
+    return 0;
+}
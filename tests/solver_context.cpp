@@ -0,0 +1,374 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+// The inputs and results of one solve
+struct ContextRun {
+    int size;
+    double** qubo;
+    int8_t** solution_list;
+    double energy_list[21];
+    int solution_counts[21];
+    int Qindex[21];
+    qbsolv_context_t ctx;
+
+    ContextRun(int size, unsigned seed) : size(size) {
+        qubo = (double**)malloc2D_triangular(size, sizeof(double));
+        randomQubo(size, seed, qubo, bqpValues, false);
+        solution_list = (int8_t**)malloc2D(21, size, sizeof(int8_t));
+        ctx = default_context();
+        ctx.out = tmpfile();
+    }
+    ~ContextRun() {
+        fclose(ctx.out);
+        free(solution_list);
+        free(qubo);
+    }
+
+    void solve() {
+        parameters_t param = default_parameters();
+        param.repeats = 3;
+        solve_context(&ctx, qubo, size, solution_list, energy_list, solution_counts, Qindex, 20, &param);
+    }
+
+    // the number of results printed to ctx.out
+    int printed() {
+        char line[4096];
+        int count = 0;
+        rewind(ctx.out);
+        while (fgets(line, sizeof(line), ctx.out) != NULL) count += strstr(line, "Energy of solution") != NULL;
+        return count;
+    }
+};
+
+// solve with the globals is solve_context with the same options
+TEST(solve_context, matches_globals) {
+    ContextRun with_globals(120, 3), with_context(120, 3);
+
+    Verbose_ = 1;
+    findMax_ = false;
+    strcpy(algo_, "o");
+    TargetSet_ = false;
+    Time_ = 2592000;
+    Tlist_ = -1;
+    WriteMatrix_ = false;
+    outFile_ = with_globals.ctx.out;
+    numsolOut_ = 0;
+    parameters_t param = default_parameters();
+    param.repeats = 3;
+    srand(5);
+    solve(with_globals.qubo, with_globals.size, with_globals.solution_list, with_globals.energy_list,
+          with_globals.solution_counts, with_globals.Qindex, 20, &param);
+
+    with_context.ctx.verbose = 1;
+    srand(5);  // the seed solve draws from rand()
+    with_context.ctx.seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+    with_context.solve();
+
+    EXPECT_EQ(numsolOut_, with_context.ctx.num_outputs);
+    EXPECT_EQ(with_globals.printed(), with_context.printed());
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(with_globals.Qindex[i], with_context.Qindex[i]);
+        ASSERT_EQ(with_globals.energy_list[i], with_context.energy_list[i]);
+        ASSERT_EQ(with_globals.solution_counts[i], with_context.solution_counts[i]);
+    }
+    for (int i = 0; i < 120; i++) ASSERT_EQ(with_globals.solution_list[with_globals.Qindex[0]][i],
+                                            with_context.solution_list[with_context.Qindex[0]][i]);
+}
+
+// Solves with contexts of their own run side by side, each printing to its own file only,
+// leaving the globals alone and finding what it finds when run alone
+TEST(solve_context, concurrent_solves) {
+    const int num_runs = 4;
+    std::vector<ContextRun*> runs;
+    std::vector<double> alone;
+    for (int r = 0; r < num_runs; r++) {
+        runs.push_back(new ContextRun(100 + 20 * r, 10 + r));
+        runs[r]->ctx.verbose = r % 2;
+        runs[r]->ctx.find_max = r == 3;
+        runs[r]->ctx.seed = 100 + r;
+        runs[r]->solve();
+        alone.push_back(runs[r]->energy_list[runs[r]->Qindex[0]]);
+        runs[r]->ctx.num_outputs = 0;
+        rewind(runs[r]->ctx.out);
+        ASSERT_EQ(0, ftruncate(fileno(runs[r]->ctx.out), 0));
+    }
+
+    numsolOut_ = -7;
+    std::vector<std::thread> threads;
+    for (int r = 0; r < num_runs; r++) threads.push_back(std::thread(&ContextRun::solve, runs[r]));
+    for (int r = 0; r < num_runs; r++) threads[r].join();
+    EXPECT_EQ(-7, numsolOut_);
+
+    for (int r = 0; r < num_runs; r++) {
+        ContextRun* run = runs[r];
+        int best = run->Qindex[0];
+        qubo_matrix_t matrix = dense_qubo_matrix(run->qubo, run->size);
+        double flip_cost[run->size];
+        EXPECT_EQ(alone[r], run->energy_list[best]);
+        EXPECT_EQ(run->energy_list[best], qubo_evaluate(run->solution_list[best], &matrix, flip_cost));
+        EXPECT_LE(1, run->ctx.num_outputs);
+        EXPECT_EQ(run->ctx.num_outputs, run->printed());
+        delete run;
+    }
+}
+
+// A quiet solve prints nothing whatever verbose, and finds what a solve that prints does
+TEST(solve_context, quiet) {
+    ContextRun loud(100, 5), quiet(100, 5);
+    loud.ctx.verbose = 1;
+    loud.solve();
+    quiet.ctx.verbose = 1;
+    quiet.ctx.quiet = true;
+    quiet.solve();
+    EXPECT_LE(1, loud.printed());
+    EXPECT_EQ(0, quiet.printed());
+    EXPECT_EQ(0, ftell(quiet.ctx.out));
+    EXPECT_EQ(loud.energy_list[loud.Qindex[0]], quiet.energy_list[quiet.Qindex[0]]);
+}
+
+// A solve that would run for long returns its best solution at the wall clock timeout
+TEST(solve_context, stops_at_deadline) {
+    ContextRun run(400, 8);
+    parameters_t param = default_parameters();
+    param.repeats = 1000000;
+    run.ctx.timeout = 0.3;
+
+    double start = solver_wall_seconds();
+    solve_context(&run.ctx, run.qubo, run.size, run.solution_list, run.energy_list, run.solution_counts, run.Qindex,
+                  20, &param);
+    double elapsed = solver_wall_seconds() - start;
+    EXPECT_LE(0.3, elapsed);
+    EXPECT_GT(0.5, elapsed);
+
+    int best = run.Qindex[0];
+    qubo_matrix_t matrix = dense_qubo_matrix(run.qubo, run.size);
+    double flip_cost[run.size];
+    EXPECT_EQ(run.energy_list[best], qubo_evaluate(run.solution_list[best], &matrix, flip_cost));
+    EXPECT_EQ(1, run.printed());
+}
+
+// The seconds printed are wall clock seconds, not the CPU time of every thread added up
+TEST(solve_context, prints_wall_seconds) {
+    ContextRun run(400, 8);
+    parameters_t param = default_parameters();
+    param.repeats = 1000000;
+    param.num_threads = 2;
+    param.num_islands = 2;
+    run.ctx.timeout = 0.3;
+
+    double start = solver_wall_seconds();
+    solve_context(&run.ctx, run.qubo, run.size, run.solution_list, run.energy_list, run.solution_counts, run.Qindex,
+                  20, &param);
+    double elapsed = solver_wall_seconds() - start;
+
+    char line[4096];
+    double printed = -1.0;
+    rewind(run.ctx.out);
+    while (fgets(line, sizeof(line), run.ctx.out) != NULL) {
+        if (strstr(line, "seconds of wall clock time") != NULL) printed = atof(line);
+    }
+    EXPECT_LE(0.3, printed);
+    EXPECT_GE(elapsed, printed);
+}
+
+// What the progress callback of a solve was called with
+struct Progress {
+    std::vector<double> energies;
+    std::vector<double> seconds;
+    int stop_after;  // calls before asking the solve to stop, 0 never
+};
+
+static bool recordProgress(const int8_t* solution, int size, double energy, double seconds, int64_t bit_flips,
+                           long numPartCalls, void* data) {
+    Progress* progress = (Progress*)data;
+    EXPECT_EQ(400, size);
+    EXPECT_LT(0, bit_flips);
+    EXPECT_LE(0, numPartCalls);
+    EXPECT_NE((const int8_t*)NULL, solution);
+    progress->energies.push_back(energy);
+    progress->seconds.push_back(seconds);
+    return progress->stop_after == 0 || (int)progress->energies.size() < progress->stop_after;
+}
+
+// Every better solution is passed to the callback, the last one is the result
+TEST(solve_context, reports_progress) {
+    ContextRun run(400, 9);
+    Progress progress;
+    progress.stop_after = 0;
+    parameters_t param = default_parameters();
+    param.repeats = 10;
+    param.progress = &recordProgress;
+    param.progress_data = &progress;
+    solve_context(&run.ctx, run.qubo, run.size, run.solution_list, run.energy_list, run.solution_counts, run.Qindex,
+                  20, &param);
+
+    ASSERT_LE(1u, progress.energies.size());
+    for (size_t i = 1; i < progress.energies.size(); i++) {
+        EXPECT_LT(progress.energies[i], progress.energies[i - 1]);  // minimizing
+        EXPECT_LE(progress.seconds[i - 1], progress.seconds[i]);
+    }
+    EXPECT_EQ(-run.energy_list[run.Qindex[0]], progress.energies.back());
+}
+
+// A callback returning false stops the solve with what it has, it would not end by itself
+TEST(solve_context, progress_stops_solve) {
+    for (int num_islands = 1; num_islands <= 2; num_islands++) {
+        ContextRun run(400, 9);
+        Progress progress;
+        progress.stop_after = 1;
+        parameters_t param = default_parameters();
+        param.repeats = 1000000;
+        param.num_islands = num_islands;
+        param.progress = &recordProgress;
+        param.progress_data = &progress;
+        solve_context(&run.ctx, run.qubo, run.size, run.solution_list, run.energy_list, run.solution_counts,
+                      run.Qindex, 20, &param);
+
+        // islands may still share what they found before they saw the request
+        if (num_islands == 1) {
+            EXPECT_EQ(1u, progress.energies.size());
+        }
+        ASSERT_LE(1u, progress.energies.size());
+        EXPECT_EQ(-run.energy_list[run.Qindex[0]], progress.energies.back());
+        EXPECT_EQ(1, run.printed());
+    }
+}
+
+// Setting the cancel flag from another thread stops a solve that would not end by itself
+TEST(solve_context, cancel_stops_solve) {
+    ContextRun run(400, 10);
+    parameters_t param = default_parameters();
+    param.repeats = 1000000;
+    volatile sig_atomic_t cancel = 0;
+    run.ctx.cancel = &cancel;
+
+    double start = solver_wall_seconds();
+    std::thread canceller([&cancel]() {
+        usleep(200000);
+        cancel = 1;
+    });
+    solve_context(&run.ctx, run.qubo, run.size, run.solution_list, run.energy_list, run.solution_counts, run.Qindex,
+                  20, &param);
+    double elapsed = solver_wall_seconds() - start;
+    canceller.join();
+    EXPECT_LE(0.2, elapsed);
+    EXPECT_GT(0.4, elapsed);
+
+    int best = run.Qindex[0];
+    qubo_matrix_t matrix = dense_qubo_matrix(run.qubo, run.size);
+    double flip_cost[run.size];
+    EXPECT_EQ(run.energy_list[best], qubo_evaluate(run.solution_list[best], &matrix, flip_cost));
+    EXPECT_EQ(1, run.printed());
+}
+
+// A solve warm started from the result of another, and a worse solution, starts from that result
+TEST(solve_context, warm_start) {
+    ContextRun cold(400, 11), warm(400, 11);
+    cold.solve();
+    int8_t alternating[400];
+    for (int i = 0; i < 400; i++) alternating[i] = i % 2;
+    int8_t* initial[2] = {alternating, cold.solution_list[cold.Qindex[0]]};
+
+    parameters_t param = default_parameters();
+    param.repeats = 0;  // the initial search only
+    param.initial_solutions = initial;
+    param.num_initial_solutions = 2;
+    warm.ctx.seed = 99;
+    solve_context(&warm.ctx, warm.qubo, warm.size, warm.solution_list, warm.energy_list, warm.solution_counts,
+                  warm.Qindex, 20, &param);
+
+    int best = warm.Qindex[0];
+    qubo_matrix_t matrix = dense_qubo_matrix(warm.qubo, warm.size);
+    double flip_cost[warm.size];
+    EXPECT_LE(cold.energy_list[cold.Qindex[0]], warm.energy_list[best]);
+    EXPECT_EQ(warm.energy_list[best], qubo_evaluate(warm.solution_list[best], &matrix, flip_cost));
+}
+
+// Changes applied to a solved state keep its energies and flip costs exact, and the solve
+// resumed from it is at least as good as the patched solution it starts from
+TEST(solve_context, resumes_after_changes) {
+    for (int layout = 0; layout < 2; layout++) {
+        ContextRun run(300, 12);
+        std::vector<int32_t> rows, cols;
+        std::vector<double> values;
+        for (int i = 0; i < run.size; i++) {
+            for (int j = i; j < run.size; j++) {
+                if (run.qubo[i][j] == 0.0) continue;
+                rows.push_back(i);
+                cols.push_back(j);
+                values.push_back(run.qubo[i][j]);
+            }
+        }
+        sparse_qubo_t* sparse = sparse_qubo_create(run.size, values.size(), &rows[0], &cols[0], &values[0]);
+        qubo_matrix_t matrix = dense_qubo_matrix(run.qubo, run.size);
+        if (layout == 1) {
+            matrix.layout = QUBO_SPARSE;
+            matrix.dense = NULL;
+            matrix.sparse = sparse;
+        }
+        qbsolv_state_t* state = qbsolv_state_create(run.size, 20);
+        parameters_t param = default_parameters();
+        param.repeats = 3;
+        solve_qubo_state(&run.ctx, &matrix, state, &param);
+        ASSERT_TRUE(state->valid);
+
+        // couplers the sparse layout has
+        qubo_change_t changes[3] = {{4, 4, -37.0}, {2, sparse->columns[sparse->row_start[2]], 81.0},
+                                    {17, sparse->columns[sparse->row_start[18] - 1], -5.5}};
+        ASSERT_EQ(0, qubo_apply_changes(&matrix, state, changes, 3));
+        double flip_cost[run.size];
+        EXPECT_DOUBLE_EQ(qubo_evaluate(state->solution, &matrix, flip_cost), state->energy);
+        for (int i = 0; i < run.size; i++) ASSERT_DOUBLE_EQ(flip_cost[i], state->flip_cost[i]);
+        for (int i = 0; i < 20; i++) {
+            if (state->energy_list[i] == BIGNEGFP) continue;
+            EXPECT_DOUBLE_EQ(qubo_evaluate(state->solution_list[i], &matrix, flip_cost), state->energy_list[i]);
+        }
+
+        qubo_change_t outside = {5, 300, 1.0};
+        EXPECT_EQ(-1, qubo_apply_changes(&matrix, state, &outside, 1));
+        double patched = state->energy;
+        solve_qubo_state(&run.ctx, &matrix, state, &param);
+        int best = state->Qindex[0];
+        EXPECT_LE(patched, state->energy_list[best]);
+        EXPECT_EQ(state->energy_list[best], qubo_evaluate(state->solution_list[best], &matrix, flip_cost));
+        EXPECT_EQ(state->energy_list[best], state->energy);
+        qbsolv_state_free(state);
+        sparse_qubo_free(sparse);
+    }
+}
+
+// A coupler given twice is one entry of the sparse layout, set as a whole, and a state of another
+// size is refused
+TEST(solve_context, changes_repeated_coupler) {
+    int32_t rows[] = {0, 0, 1, 0, 1};
+    int32_t cols[] = {0, 1, 1, 1, 2};
+    double values[] = {1.0, -2.0, 3.0, -4.0, 5.0};
+    sparse_qubo_t* sparse = sparse_qubo_create(3, 5, rows, cols, values);
+    qubo_matrix_t matrix;
+    matrix.layout = QUBO_SPARSE;
+    matrix.size = 3;
+    matrix.dense = NULL;
+    matrix.single = NULL;
+    matrix.integer = NULL;
+    matrix.sparse = sparse;
+
+    int8_t ones[] = {1, 1, 1};
+    double flip_cost[3];
+    EXPECT_DOUBLE_EQ(1.0 - 6.0 + 3.0 + 5.0, qubo_evaluate(ones, &matrix, flip_cost));
+    qubo_change_t change = {0, 1, 7.0};
+    ASSERT_EQ(0, qubo_apply_changes(&matrix, NULL, &change, 1));
+    EXPECT_DOUBLE_EQ(1.0 + 7.0 + 3.0 + 5.0, qubo_evaluate(ones, &matrix, flip_cost));
+
+    qbsolv_state_t* state = qbsolv_state_create(4, 20);
+    EXPECT_EQ(-1, qubo_apply_changes(&matrix, state, &change, 1));
+    qbsolv_state_free(state);
+    sparse_qubo_free(sparse);
+}
@@ -0,0 +1,82 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+TEST(float_qubo, mirror) {
+    double** qubo = (double**)malloc2D_triangular(4, sizeof(double));
+    randomQubo(4, 3, qubo, thirdValues, false);
+    float** single = float_qubo_create(qubo, 4);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = i; j < 4; j++) {
+            EXPECT_EQ((float)qubo[i][j], single[i][j]);
+            EXPECT_EQ((float)qubo[i][j], single[j][i]);
+        }
+    }
+    free(single);
+    free(qubo);
+}
+
+TEST(float_qubo, evaluate_1bit_tracks_single_precision) {
+    const int size = 40;
+    double** qubo = (double**)malloc2D_triangular(size, sizeof(double));
+    randomQubo(size, 5, qubo, thirdValues, false);
+    float** single = float_qubo_create(qubo, size);
+
+    // the same problem rounded to single precision, in double
+    double** rounded = (double**)malloc2D_triangular(size, sizeof(double));
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) rounded[i][j] = single[i][j];
+    }
+
+    int8_t solution[size], rounded_solution[size];
+    double flip_cost[size], rounded_flip_cost[size];
+    randomize_solution(solution, size);
+    for (int i = 0; i < size; i++) rounded_solution[i] = solution[i];
+
+    double energy = evaluate(solution, size, (const double**)rounded, flip_cost);
+    double rounded_energy = evaluate(rounded_solution, size, (const double**)rounded, rounded_flip_cost);
+    for (int step = 0; step < 100; step++) {
+        uint bit = (step * 13) % size;
+        energy = evaluate_1bit_float(energy, bit, solution, size, (const float**)single, flip_cost);
+        rounded_energy =
+            evaluate_1bit(rounded_energy, bit, rounded_solution, size, (const double**)rounded, rounded_flip_cost);
+        ASSERT_DOUBLE_EQ(rounded_energy, energy);
+        for (int i = 0; i < size; i++) ASSERT_DOUBLE_EQ(rounded_flip_cost[i], flip_cost[i]);
+    }
+
+    free(rounded);
+    free(single);
+    free(qubo);
+}
+
+TEST(float_qubo, tabu_returns_double_energy) {
+    const int size = 60;
+    double** qubo = (double**)malloc2D_triangular(size, sizeof(double));
+    randomQubo(size, 7, qubo, thirdValues, false);
+
+    qubo_matrix_t matrix = dense_qubo_matrix(qubo, size);
+    matrix.layout = QUBO_FLOAT;
+    matrix.single = float_qubo_create(qubo, size);
+
+    int8_t solution[size], best[size];
+    double flip_cost[size];
+    int TabuK[size], index[size];
+    int64_t bit_flips = 0;
+    for (int i = 0; i < size; i++) index[i] = i;
+    randomize_solution(solution, size);
+
+    int order[size];
+    qbsolv_context_t ctx = default_context();
+    double energy = tabu_search(&ctx, solution, best, &matrix, flip_cost, &bit_flips, 50000, TabuK, 0, false, index, 0,
+                                order, NULL, NULL);
+
+    // whatever the rounding during the search, the reported energy is the double precision one
+    EXPECT_EQ(Simple_evaluate(solution, size, (const double**)qubo), energy);
+
+    free(matrix.single);
+    free(qubo);
+}
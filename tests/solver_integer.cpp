@@ -0,0 +1,92 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+TEST(integer_qubo, integral) {
+    double** qubo = (double**)malloc2D_triangular(4, sizeof(double));
+    randomQubo(4, 3, qubo, integerValues, false);
+    EXPECT_TRUE(qubo_is_integral(qubo, 4));
+
+    qubo[1][3] = 0.5;
+    EXPECT_FALSE(qubo_is_integral(qubo, 4));
+
+    qubo[1][3] = 4294967296.0;
+    EXPECT_FALSE(qubo_is_integral(qubo, 4));
+
+    qubo[1][3] = INT32_MIN;  // the bit flip kernels negate the coefficients
+    EXPECT_FALSE(qubo_is_integral(qubo, 4));
+    qubo[1][3] = -INT32_MAX;
+    EXPECT_TRUE(qubo_is_integral(qubo, 4));
+    free(qubo);
+}
+
+// The extremes of the integer layout flip exactly, and a change to INT32_MIN is refused
+TEST(integer_qubo, extreme_coefficients) {
+    const int size = 6;
+    double** qubo = (double**)malloc2D_triangular(size, sizeof(double));
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) qubo[i][j] = (i + j) % 2 ? -INT32_MAX : INT32_MAX;
+    }
+    ASSERT_TRUE(qubo_is_integral(qubo, size));
+    int32_t** integer = integer_qubo_create(qubo, size);
+
+    int8_t dense_solution[size], integer_solution[size];
+    double dense_flip_cost[size], integer_flip_cost[size];
+    for (int i = 0; i < size; i++) dense_solution[i] = integer_solution[i] = i % 2;
+    double dense_energy = evaluate(dense_solution, size, (const double**)qubo, dense_flip_cost);
+    double integer_energy = evaluate_integer(integer_solution, size, (const int32_t**)integer, integer_flip_cost);
+    for (int step = 0; step < 30; step++) {
+        uint bit = (step * 5) % size;
+        dense_energy = evaluate_1bit(dense_energy, bit, dense_solution, size, (const double**)qubo, dense_flip_cost);
+        integer_energy = evaluate_1bit_integer(integer_energy, bit, integer_solution, size, (const int32_t**)integer,
+                                               integer_flip_cost);
+        ASSERT_EQ(dense_energy, integer_energy);
+        for (int i = 0; i < size; i++) ASSERT_EQ(dense_flip_cost[i], integer_flip_cost[i]);
+    }
+
+    qubo_matrix_t matrix = dense_qubo_matrix(qubo, size);
+    matrix.layout = QUBO_INTEGER;
+    matrix.integer = integer;
+    qubo_change_t change = {1, 4, (double)INT32_MIN};
+    EXPECT_EQ(-1, qubo_apply_changes(&matrix, NULL, &change, 1));
+    EXPECT_EQ(-INT32_MAX, integer[1][4]);
+    change.value = -INT32_MAX + 1.0;
+    EXPECT_EQ(0, qubo_apply_changes(&matrix, NULL, &change, 1));
+    EXPECT_EQ(-INT32_MAX + 1, integer[4][1]);
+
+    free(integer);
+    free(qubo);
+}
+
+TEST(integer_qubo, evaluate_matches_dense) {
+    const int size = 40;
+    double** qubo = (double**)malloc2D_triangular(size, sizeof(double));
+    randomQubo(size, 5, qubo, integerValues, false);
+    int32_t** integer = integer_qubo_create(qubo, size);
+
+    int8_t dense_solution[size], integer_solution[size];
+    double dense_flip_cost[size], integer_flip_cost[size];
+    randomize_solution(dense_solution, size);
+    for (int i = 0; i < size; i++) integer_solution[i] = dense_solution[i];
+
+    double dense_energy = evaluate(dense_solution, size, (const double**)qubo, dense_flip_cost);
+    double integer_energy = evaluate_integer(integer_solution, size, (const int32_t**)integer, integer_flip_cost);
+    ASSERT_EQ(dense_energy, integer_energy);
+    for (int i = 0; i < size; i++) ASSERT_EQ(dense_flip_cost[i], integer_flip_cost[i]);
+
+    for (int step = 0; step < 100; step++) {
+        uint bit = (step * 13) % size;
+        dense_energy = evaluate_1bit(dense_energy, bit, dense_solution, size, (const double**)qubo, dense_flip_cost);
+        integer_energy = evaluate_1bit_integer(integer_energy, bit, integer_solution, size, (const int32_t**)integer,
+                                               integer_flip_cost);
+        ASSERT_EQ(dense_energy, integer_energy);
+        for (int i = 0; i < size; i++) ASSERT_EQ(dense_flip_cost[i], integer_flip_cost[i]);
+    }
+    ASSERT_EQ(Simple_evaluate(integer_solution, size, (const double**)qubo), integer_energy);
+
+    free(integer);
+    free(qubo);
+}
@@ -0,0 +1,296 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "thread_pool.h"
+#include "util.h"
+
+#include <atomic>
+#include <vector>
+
+static void countTask(void* data, int task) { ((std::atomic<int>*)data)[task]++; }
+
+TEST(thread_pool, runs_every_task_once) {
+    std::atomic<int> counts[100];
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        struct thread_pool* pool = thread_pool_create(threads);
+        ASSERT_EQ(threads, thread_pool_size(pool));
+        for (int batch = 0; batch < 20; batch++) {
+            int num_tasks = (batch * 7) % 100;
+            for (int i = 0; i < 100; i++) counts[i] = 0;
+            thread_pool_run(pool, num_tasks, countTask, counts);
+            for (int i = 0; i < 100; i++) ASSERT_EQ(i < num_tasks ? 1 : 0, counts[i]);
+        }
+        thread_pool_free(pool);
+    }
+}
+
+TEST(solver_rand, stream_is_reproducible) {
+    solver_rng_t first, second, other;
+    solver_rng_seed(&first, 42);
+    solver_rng_seed(&second, 42);
+    solver_rng_seed(&other, 43);
+    uint64_t a[50];
+
+    EXPECT_EQ(NULL, solver_rand_stream(&first));
+    for (int i = 0; i < 50; i++) a[i] = solver_rand64();
+    EXPECT_EQ(&first, solver_rand_stream(&second));
+    for (int i = 0; i < 50; i++) ASSERT_EQ(a[i], solver_rand64());
+
+    // a nearby seed is a different stream
+    solver_rand_stream(&other);
+    int same = 0;
+    for (int i = 0; i < 50; i++) same += a[i] == solver_rand64();
+    EXPECT_EQ(0, same);
+    solver_rand_stream(NULL);
+}
+
+TEST(solver_rand, below_is_in_range_and_uniform) {
+    solver_rng_t rng;
+    solver_rng_seed(&rng, 7);
+    solver_rand_stream(&rng);
+
+    const int n = 6, draws = 60000;
+    int counts[n] = {0};
+    for (int i = 0; i < draws; i++) {
+        uint32_t j = solver_rand_below(n);
+        ASSERT_LT(j, (uint32_t)n);
+        counts[j]++;
+    }
+    for (int j = 0; j < n; j++) EXPECT_NEAR(draws / n, counts[j], draws / n / 20);
+    EXPECT_EQ(0u, solver_rand_below(1));
+
+    // randomize_solution takes 64 bits a draw, the bits are still about half ones
+    int8_t solution[1000];
+    randomize_solution(solution, 1000);
+    int ones = 0;
+    for (int i = 0; i < 1000; i++) ones += solution[i];
+    EXPECT_NEAR(500, ones, 60);
+    solver_rand_stream(NULL);
+}
+
+// A sparse QUBO of size variables with about degree couplers per variable
+static sparse_qubo_t* sparseQubo(int size, int degree, unsigned seed) {
+    srand(seed);
+    int64_t num_entries = (int64_t)size * (degree / 2 + 1);
+    int32_t* rows = (int32_t*)malloc(num_entries * sizeof(int32_t));
+    int32_t* cols = (int32_t*)malloc(num_entries * sizeof(int32_t));
+    double* values = (double*)malloc(num_entries * sizeof(double));
+    int64_t n = 0;
+    for (int i = 0; i < size; i++) {
+        rows[n] = cols[n] = i;
+        values[n++] = (rand() % 201) - 100;
+        for (int k = 0; k < degree / 2; k++) {
+            int j = rand() % size;
+            rows[n] = MIN(i, j);
+            cols[n] = MAX(i, j);
+            values[n++] = (rand() % 201) - 100;
+        }
+    }
+    sparse_qubo_t* qubo = sparse_qubo_create(size, n, rows, cols, values);
+    free(values);
+    free(cols);
+    free(rows);
+    return qubo;
+}
+
+// Solve qubo from the same seed and return the best energy, copying its solution out
+static double solveWith(const qubo_matrix_t* qubo, int num_threads, bool independent, int8_t* best) {
+    const int QLEN = 20;
+    int8_t** solution_list = (int8_t**)malloc2D(QLEN + 1, qubo->size, sizeof(int8_t));
+    double energy_list[QLEN + 1];
+    int solution_counts[QLEN + 1];
+    int Qindex[QLEN + 1];
+
+    outFile_ = tmpfile();
+    Verbose_ = 0;
+    strcpy(algo_, "o");
+    Time_ = 2592000;
+    findMax_ = false;
+    TargetSet_ = false;
+    WriteMatrix_ = false;
+    numsolOut_ = 0;
+
+    parameters_t param = default_parameters();
+    param.repeats = 4;
+    param.sub_size = 20;
+    param.num_threads = num_threads;
+    param.independent_groups = independent;
+    srand(11);
+    solve_qubo(qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, &param);
+    fclose(outFile_);
+
+    double energy = energy_list[Qindex[0]];
+    for (int i = 0; i < qubo->size; i++) best[i] = solution_list[Qindex[0]][i];
+    free(solution_list);
+    return energy;
+}
+
+// The merge is in pass order, so repeating a parallel solve gives the same answer, and the
+// energy reported is the one of the solution reported
+static void checkParallel(bool independent) {
+    const int size = 400;
+    sparse_qubo_t* sparse = sparseQubo(size, 6, 3);
+    qubo_matrix_t qubo;
+    qubo.layout = QUBO_SPARSE;
+    qubo.size = size;
+    qubo.dense = NULL;
+    qubo.single = NULL;
+    qubo.integer = NULL;
+    qubo.sparse = sparse;
+
+    int8_t first[size], second[size];
+    double flip_cost[size];
+    double energy = solveWith(&qubo, 4, independent, first);
+    ASSERT_EQ(energy, solveWith(&qubo, 4, independent, second));
+    for (int i = 0; i < size; i++) ASSERT_EQ(first[i], second[i]);
+    EXPECT_EQ(energy, qubo_evaluate(first, &qubo, flip_cost));
+
+    sparse_qubo_free(sparse);
+}
+
+TEST(solve_parallel, deterministic) { checkParallel(false); }
+
+TEST(solve_parallel, independent_groups_deterministic) { checkParallel(true); }
+
+// Solve qubo with num_islands islands and return the best energy, checking every entry of the
+// solution tables is a solution with the energy listed for it
+static double solveIslands(const qubo_matrix_t* qubo, int num_islands, qbsolv_context_t* ctx) {
+    const int QLEN = 20;
+    int8_t** solution_list = (int8_t**)malloc2D(QLEN + 1, qubo->size, sizeof(int8_t));
+    double energy_list[QLEN + 1];
+    int solution_counts[QLEN + 1];
+    int Qindex[QLEN + 1];
+    double flip_cost[qubo->size];
+
+    parameters_t param = default_parameters();
+    param.repeats = 4;
+    param.sub_size = 20;
+    param.num_islands = num_islands;
+    param.migration_interval = 2;
+    solve_qubo_context(ctx, qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, &param);
+
+    for (int i = 0; i < QLEN && energy_list[Qindex[i]] != BIGNEGFP; i++) {
+        EXPECT_EQ(energy_list[Qindex[i]], qubo_evaluate(solution_list[Qindex[i]], qubo, flip_cost));
+        if (i > 0) {
+            EXPECT_LE(energy_list[Qindex[i]], energy_list[Qindex[i - 1]]);
+        }
+    }
+    double energy = energy_list[Qindex[0]];
+    free(solution_list);
+    return energy;
+}
+
+// The islands report a consistent best, print it once, and stop together at the target
+TEST(solve_islands, share_their_best) {
+    const int size = 400;
+    sparse_qubo_t* sparse = sparseQubo(size, 6, 5);
+    qubo_matrix_t qubo;
+    qubo.layout = QUBO_SPARSE;
+    qubo.size = size;
+    qubo.dense = NULL;
+    qubo.single = NULL;
+    qubo.integer = NULL;
+    qubo.sparse = sparse;
+
+    qbsolv_context_t ctx = default_context();
+    ctx.out = tmpfile();
+    ctx.seed = 21;
+    double alone = solveIslands(&qubo, 1, &ctx);
+    EXPECT_EQ(1, ctx.num_outputs);
+
+    ctx.num_outputs = 0;
+    solveIslands(&qubo, 3, &ctx);
+    EXPECT_EQ(1, ctx.num_outputs);
+
+    // minimizing, the energies of the tables are the negated QUBO values
+    ctx.target_set = true;
+    ctx.target = -alone;
+    ctx.timeout = 60;
+    EXPECT_LE(alone, solveIslands(&qubo, 3, &ctx));
+
+    fclose(ctx.out);
+    sparse_qubo_free(sparse);
+}
+
+// A batch finds the same solutions whatever the number of workers, each QUBO solved as it would
+// be alone with the seed drawn for it, and prints nothing
+TEST(solve_batch, independent_of_workers) {
+    const int num_qubos = 12;
+    std::vector<sparse_qubo_t*> sparse;
+    std::vector<qubo_matrix_t> qubos(num_qubos);
+    int64_t total = 0;
+    for (int q = 0; q < num_qubos; q++) {
+        sparse.push_back(sparseQubo(50 + 20 * q, 6, 30 + q));
+        qubos[q].layout = QUBO_SPARSE;
+        qubos[q].size = 50 + 20 * q;
+        qubos[q].dense = NULL;
+        qubos[q].single = NULL;
+        qubos[q].integer = NULL;
+        qubos[q].sparse = sparse[q];
+        total += qubos[q].size;
+    }
+
+    qbsolv_context_t ctx = default_context();
+    ctx.out = tmpfile();
+    ctx.seed = 8;
+    parameters_t param = default_parameters();
+    param.repeats = 4;
+    param.sub_size = 20;
+    std::vector<int8_t> first(total), solutions(total);
+    std::vector<double> first_energies(num_qubos), energies(num_qubos);
+    solve_qubo_batch(&ctx, &qubos[0], num_qubos, 20, &param, 1, &first[0], &first_energies[0]);
+    solve_qubo_batch(&ctx, &qubos[0], num_qubos, 20, &param, 4, &solutions[0], &energies[0]);
+    EXPECT_EQ(0, ftell(ctx.out));
+
+    int8_t* solution = &solutions[0];
+    for (int q = 0; q < num_qubos; q++) {
+        double flip_cost[qubos[q].size];
+        EXPECT_EQ(first_energies[q], energies[q]);
+        EXPECT_EQ(energies[q], qubo_evaluate(solution, &qubos[q], flip_cost));
+        solution += qubos[q].size;
+        sparse_qubo_free(sparse[q]);
+    }
+    EXPECT_TRUE(first == solutions);
+    fclose(ctx.out);
+}
+
+// Solves in one kept workspace, growing QUBO after QUBO, find what solves of their own do
+TEST(solve_workspace, matches_own_workspace) {
+    const int QLEN = 20, max_size = 160;
+    int8_t** solution_list = (int8_t**)malloc2D(QLEN + 1, max_size, sizeof(int8_t));
+    int8_t** own_list = (int8_t**)malloc2D(QLEN + 1, max_size, sizeof(int8_t));
+    double energy_list[QLEN + 1], own_energies[QLEN + 1];
+    int solution_counts[QLEN + 1], Qindex[QLEN + 1], own_counts[QLEN + 1], own_index[QLEN + 1];
+
+    qbsolv_context_t ctx = default_context();
+    ctx.quiet = true;
+    parameters_t param = default_parameters();
+    param.repeats = 4;
+    param.sub_size = 20;
+    param.num_threads = 3;
+    solver_workspace_t* work = solver_workspace_create(max_size, param.sub_size);
+    for (int size = 60; size <= max_size; size += 50) {
+        for (int threaded = 1; threaded >= 0; threaded--) {  // with the kept threads, then without
+            sparse_qubo_t* sparse = sparseQubo(size, 6, size + threaded);
+            qubo_matrix_t qubo;
+            qubo.layout = QUBO_SPARSE;
+            qubo.size = size;
+            qubo.dense = NULL;
+            qubo.single = NULL;
+            qubo.integer = NULL;
+            qubo.sparse = sparse;
+            ctx.seed = size;
+            param.num_threads = threaded ? 3 : 1;
+            solve_qubo_workspace(&ctx, &qubo, solution_list, energy_list, solution_counts, Qindex, QLEN, &param, work);
+            solve_qubo_context(&ctx, &qubo, own_list, own_energies, own_counts, own_index, QLEN, &param);
+
+            ASSERT_EQ(own_energies[own_index[0]], energy_list[Qindex[0]]);
+            for (int i = 0; i < size; i++) ASSERT_EQ(own_list[own_index[0]][i], solution_list[Qindex[0]][i]);
+            sparse_qubo_free(sparse);
+        }
+    }
+    solver_workspace_free(work);
+    free(solution_list);
+    free(own_list);
+}
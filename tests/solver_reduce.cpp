@@ -22,6 +22,8 @@ TEST(clamp_function, small_system) {
     // Declare the full QUBO
     int maxNodes = 2;
     double** quboMat = (double**)malloc2D(2, 2, sizeof(double));
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++) quboMat[i][j] = 0;  // malloc2D does not clear
 
     // Encode simple 2 variable system
     // E(a, b) = 2a + 2ab + 3b
@@ -142,6 +144,8 @@ TEST(clamp_function, offset_small_system) {
     // Declare the full QUBO
     int maxNodes = 4;
     double** quboMat = (double**)malloc2D(4, 4, sizeof(double));
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++) quboMat[i][j] = 0;  // malloc2D does not clear
 
     // Encode simple 2 variable system
     // E(a, b) = 2a + 2ab + 3b
@@ -260,6 +264,8 @@ TEST(clamp_function, five_system) {
     // Declare the full QUBO
     int maxNodes = 5;
     double** quboMat = (double**)malloc2D(5, 5, sizeof(double));
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 5; j++) quboMat[i][j] = 0;  // malloc2D does not clear
 
     // Encode simple 2 variable system
     // E(b) = b_0 + 2b_1 - 3b_2 + 4b_3 + 2b_4 +
@@ -483,6 +489,8 @@ TEST(clamp_function, non_contiguous_subsection) {
     // Declare the full QUBO
     int maxNodes = 5;
     double** quboMat = (double**)malloc2D(5, 5, sizeof(double));
+    for (int i = 0; i < 5; i++)
+        for (int j = 0; j < 5; j++) quboMat[i][j] = 0;  // malloc2D does not clear
 
     // Encode simple 2 variable system
     // E(b) = b_0 + 2b_1 - 3b_2 + 4b_3 + 2b_4 +
@@ -535,3 +543,136 @@ TEST(clamp_function, non_contiguous_subsection) {
     EXPECT_EQ(1, selectionState[0]);
     EXPECT_EQ(1, selectionState[1]);
 }
+
+// Check reduce_flip_cost against reduce on a random QUBO and random subregions, exactly when the
+// coefficients are integers
+static void checkFlipCostReduce(qubo_layout_t layout, bool integral) {
+    const int size = 300, sub_size = 47;
+    double** dense = (double**)malloc2D_aligned(size, size, sizeof(double));
+    double** mirrored = (double**)malloc2D_aligned(size, size, sizeof(double));
+    srand(9);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) dense[i][j] = 0.0;
+        for (int j = i; j < size; j++) {
+            if (rand() % 3 == 0) dense[i][j] = integral ? (rand() % 201) - 100 : ((rand() % 2001) - 1000) / 7.0;
+        }
+    }
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++) mirrored[i][j] = dense[i][j];
+    symmetrize_qubo(mirrored, size);
+
+    qubo_matrix_t qubo = dense_qubo_matrix(layout == QUBO_SYMMETRIC ? mirrored : dense, size);
+    qubo.layout = layout;
+    ASSERT_TRUE(reduce_flip_cost_layout(&qubo));
+
+    int8_t solution[size], sub_solution[sub_size], flip_sub_solution[sub_size];
+    double flip_cost[size];
+    int index[size], Icompress[sub_size];
+    double** sub_qubo = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+    double** flip_sub_qubo = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+
+    for (int trial = 0; trial < 10; trial++) {
+        randomize_solution(solution, size);
+        qubo_evaluate(solution, &qubo, flip_cost);
+        for (int i = 0; i < size; i++) index[i] = i;
+        shuffle_index(index, size);
+        for (int i = 0; i < sub_size; i++) Icompress[i] = index[i];
+        index_sort(Icompress, sub_size, true);
+
+        reduce(Icompress, dense, sub_size, size, sub_qubo, solution, sub_solution);
+        reduce_flip_cost(Icompress, &qubo, sub_size, flip_sub_qubo, solution, flip_sub_solution, flip_cost);
+        for (int i = 0; i < sub_size; i++) {
+            ASSERT_EQ(sub_solution[i], flip_sub_solution[i]);
+            for (int j = i; j < sub_size; j++) {
+                if (integral)
+                    ASSERT_EQ(sub_qubo[i][j], flip_sub_qubo[i][j]);
+                else
+                    ASSERT_NEAR(sub_qubo[i][j], flip_sub_qubo[i][j], 1e-9);
+            }
+        }
+    }
+
+    free(flip_sub_qubo);
+    free(sub_qubo);
+    free(mirrored);
+    free(dense);
+}
+
+TEST(clamp_function, flip_cost_matches_reduce) {
+    checkFlipCostReduce(QUBO_DENSE, true);
+    checkFlipCostReduce(QUBO_DENSE, false);
+    checkFlipCostReduce(QUBO_SYMMETRIC, true);
+}
+
+// Projecting through flip_cost keeps it equal to a fresh evaluation
+TEST(clamp_function, project_keeps_flip_cost) {
+    const int size = 60, sub_size = 10;
+    double** dense = (double**)malloc2D_aligned(size, size, sizeof(double));
+    srand(4);
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++) dense[i][j] = j >= i ? (rand() % 21) - 10 : 0.0;
+    qubo_matrix_t qubo = dense_qubo_matrix(dense, size);
+
+    int8_t solution[size], sub_solution[sub_size];
+    double flip_cost[size], fresh[size];
+    int Icompress[sub_size];
+    randomize_solution(solution, size);
+    for (int i = 0; i < sub_size; i++) {
+        Icompress[i] = 5 * i + 1;
+        sub_solution[i] = i % 2;
+    }
+
+    double energy = qubo_evaluate(solution, &qubo, flip_cost);
+    int expect = 0;
+    for (int i = 0; i < sub_size; i++) expect += solution[Icompress[i]] != sub_solution[i];
+    qbsolv_context_t ctx = default_context();
+    EXPECT_EQ(expect,
+              project_solution(&ctx, Icompress, sub_size, sub_solution, solution, &qubo, flip_cost, &energy));
+    for (int i = 0; i < sub_size; i++) EXPECT_EQ(sub_solution[i], solution[Icompress[i]]);
+
+    EXPECT_EQ(qubo_evaluate(solution, &qubo, fresh), energy);
+    for (int i = 0; i < size; i++) EXPECT_EQ(fresh[i], flip_cost[i]);
+    free(dense);
+}
+
+// Started from a known energy and flip costs, tabu_search skips its evaluations and still ends
+// on the same state as a search that does them, on an integer QUBO where no sum rounds
+TEST(clamp_function, tabu_search_from_flip_cost) {
+    const int size = 200;
+    double** dense = (double**)malloc2D_aligned(size, size, sizeof(double));
+    srand(6);
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++) dense[i][j] = j >= i && rand() % 4 == 0 ? (rand() % 201) - 100 : 0.0;
+    qubo_matrix_t qubo = dense_qubo_matrix(dense, size);
+
+    int8_t start[size], solution[size], kept[size], best[size];
+    double flip_cost[size], kept_flip_cost[size];
+    int TabuK[size], index[size], order[size];
+    randomize_solution(start, size);
+
+    for (int i = 0; i < size; i++) solution[i] = kept[i] = start[i];
+    for (int i = 0; i < size; i++) index[i] = i;
+    int64_t bit_flips = 0;
+    qbsolv_context_t ctx = default_context();
+    solver_rng_t rng;
+    solver_rng_seed(&rng, 8);
+    solver_rand_stream(&rng);
+    double energy = tabu_search(&ctx, solution, best, &qubo, flip_cost, &bit_flips, 30000, TabuK, 0, false, index, 0,
+                                order, NULL, NULL);
+
+    for (int i = 0; i < size; i++) index[i] = i;
+    double kept_energy = qubo_evaluate(kept, &qubo, kept_flip_cost);
+    int64_t kept_bit_flips = 0;
+    solver_rng_seed(&rng, 8);
+    kept_energy = tabu_search(&ctx, kept, best, &qubo, kept_flip_cost, &kept_bit_flips, 30000, TabuK, 0, false, index,
+                              0, order, NULL, &kept_energy);
+    solver_rand_stream(NULL);
+
+    EXPECT_EQ(energy, kept_energy);
+    EXPECT_EQ(bit_flips, kept_bit_flips);
+    for (int i = 0; i < size; i++) {
+        EXPECT_EQ(solution[i], kept[i]);
+        EXPECT_EQ(flip_cost[i], kept_flip_cost[i]);
+    }
+    free(dense);
+}
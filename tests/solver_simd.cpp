@@ -0,0 +1,117 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "simd.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+// sizes around the vector widths, to cover the scalar tails of every loop
+static const int sizes[] = {1, 3, 4, 5, 8, 9, 17, 40, 67};
+
+// Check that the kernels of level match the scalar ones, on dense, symmetric and float matrices
+static void checkKernels(simd_level_t level) {
+    const simd_kernels_t* scalar = simd_kernels_for(SIMD_SCALAR);
+    const simd_kernels_t* vector = simd_kernels_for(level);
+    if (vector == NULL) return;
+
+    for (int size : sizes) {
+        double** dense = (double**)malloc2D_aligned(size, size, sizeof(double));
+        double** symmetric = (double**)malloc2D_aligned(size, size, sizeof(double));
+        randomQubo(size, 7 + size, dense, thirdValues, true);
+        randomQubo(size, 7 + size, symmetric, thirdValues, true);
+        symmetrize_qubo(symmetric, size);
+        float** single = float_qubo_create(dense, size);
+
+        int8_t* solution = (int8_t*)malloc(size);
+        int8_t* vector_solution = (int8_t*)malloc(size);
+        double* flip_cost = (double*)malloc(size * sizeof(double));
+        double* vector_flip_cost = (double*)malloc(size * sizeof(double));
+
+        // the full evaluations may round differently
+        randomize_solution(solution, size);
+        double energy = scalar->evaluate(solution, size, (const double**)dense, flip_cost);
+        double vector_energy = vector->evaluate(solution, size, (const double**)dense, vector_flip_cost);
+        EXPECT_NEAR(energy, vector_energy, 1e-9 * size);
+        for (int i = 0; i < size; i++) EXPECT_NEAR(flip_cost[i], vector_flip_cost[i], 1e-9 * size);
+
+        energy = scalar->evaluate_symmetric(solution, size, (const double**)symmetric, flip_cost);
+        vector_energy = vector->evaluate_symmetric(solution, size, (const double**)symmetric, vector_flip_cost);
+        EXPECT_NEAR(energy, vector_energy, 1e-9 * size);
+        for (int i = 0; i < size; i++) EXPECT_NEAR(flip_cost[i], vector_flip_cost[i], 1e-9 * size);
+
+        // the bit flip updates are exact, so start both from the same state and expect the same bits
+        for (int kind = 0; kind < 3; kind++) {
+            energy = scalar->evaluate(solution, size, (const double**)dense, flip_cost);
+            vector_energy = energy;
+            for (int i = 0; i < size; i++) {
+                vector_solution[i] = solution[i];
+                vector_flip_cost[i] = flip_cost[i];
+            }
+
+            for (int step = 0; step < 3 * size; step++) {
+                uint bit = (step * 13) % size;
+                if (kind == 0) {
+                    energy = scalar->evaluate_1bit(energy, bit, solution, size, (const double**)dense, flip_cost);
+                    vector_energy = vector->evaluate_1bit(vector_energy, bit, vector_solution, size,
+                                                          (const double**)dense, vector_flip_cost);
+                } else if (kind == 1) {
+                    energy = scalar->evaluate_1bit_symmetric(energy, bit, solution, size, (const double**)symmetric,
+                                                             flip_cost);
+                    vector_energy = vector->evaluate_1bit_symmetric(vector_energy, bit, vector_solution, size,
+                                                                    (const double**)symmetric, vector_flip_cost);
+                } else {
+                    energy = scalar->evaluate_1bit_float(energy, bit, solution, size, (const float**)single,
+                                                         flip_cost);
+                    vector_energy = vector->evaluate_1bit_float(vector_energy, bit, vector_solution, size,
+                                                                (const float**)single, vector_flip_cost);
+                }
+                ASSERT_EQ(energy, vector_energy);
+                for (int i = 0; i < size; i++) {
+                    ASSERT_EQ(solution[i], vector_solution[i]);
+                    ASSERT_EQ(flip_cost[i], vector_flip_cost[i]);
+                }
+            }
+        }
+
+        free(vector_flip_cost);
+        free(flip_cost);
+        free(vector_solution);
+        free(solution);
+        free(single);
+        free(symmetric);
+        free(dense);
+    }
+}
+
+TEST(simd_kernels, scalar_always_available) {
+    ASSERT_TRUE(simd_kernels_for(SIMD_SCALAR) != NULL);
+    ASSERT_TRUE(simd_kernels() != NULL);
+}
+
+TEST(simd_kernels, avx2_matches_scalar) { checkKernels(SIMD_AVX2); }
+
+TEST(simd_kernels, avx512_matches_scalar) { checkKernels(SIMD_AVX512); }
+
+// With integer coefficients no sum rounds, so the full evaluations agree exactly too
+TEST(simd_kernels, integer_evaluate_exact) {
+    const int size = 50;
+    double** dense = (double**)malloc2D_aligned(size, size, sizeof(double));
+    srand(11);
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) dense[i][j] = (rand() % 201) - 100;
+    }
+
+    int8_t solution[size];
+    double flip_cost[size], vector_flip_cost[size];
+    randomize_solution(solution, size);
+    double energy = evaluate(solution, size, (const double**)dense, flip_cost);
+
+    for (int level = SIMD_AVX2; level <= SIMD_AVX512; level++) {
+        const simd_kernels_t* vector = simd_kernels_for((simd_level_t)level);
+        if (vector == NULL) continue;
+        ASSERT_EQ(energy, vector->evaluate(solution, size, (const double**)dense, vector_flip_cost));
+        for (int i = 0; i < size; i++) ASSERT_EQ(flip_cost[i], vector_flip_cost[i]);
+    }
+    free(dense);
+}
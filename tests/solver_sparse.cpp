@@ -0,0 +1,173 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+TEST(sparse_qubo, layout) {
+    // E(b) = b_0 + 2b_1 - 3b_2 + 4 * b_0 * b_2 - 5 * b_1 * b_2
+    int32_t rows[] = {1, 0, 0, 2, 1};
+    int32_t cols[] = {2, 2, 0, 2, 1};
+    double values[] = {-5, 4, 1, -3, 2};
+
+    sparse_qubo_t* qubo = sparse_qubo_create(3, 5, rows, cols, values);
+
+    ASSERT_EQ(3, qubo->size);
+    EXPECT_DOUBLE_EQ(1, qubo->diagonal[0]);
+    EXPECT_DOUBLE_EQ(2, qubo->diagonal[1]);
+    EXPECT_DOUBLE_EQ(-3, qubo->diagonal[2]);
+
+    // every coupler shows up in both rows, with the columns in increasing order
+    ASSERT_EQ(0, qubo->row_start[0]);
+    ASSERT_EQ(1, qubo->row_start[1]);
+    ASSERT_EQ(2, qubo->row_start[2]);
+    ASSERT_EQ(4, qubo->row_start[3]);
+    EXPECT_EQ(2, qubo->columns[0]);
+    EXPECT_DOUBLE_EQ(4, qubo->values[0]);
+    EXPECT_EQ(2, qubo->columns[1]);
+    EXPECT_DOUBLE_EQ(-5, qubo->values[1]);
+    EXPECT_EQ(0, qubo->columns[2]);
+    EXPECT_DOUBLE_EQ(4, qubo->values[2]);
+    EXPECT_EQ(1, qubo->columns[3]);
+    EXPECT_DOUBLE_EQ(-5, qubo->values[3]);
+
+    sparse_qubo_free(qubo);
+}
+
+// Repeated couplers are summed into one entry of each of their rows, like repeated linear terms
+TEST(sparse_qubo, repeats_are_summed) {
+    int32_t rows[] = {0, 1, 0, 0, 1};
+    int32_t cols[] = {2, 1, 2, 1, 1};
+    double values[] = {3, 2, -1, 5, 4};
+
+    sparse_qubo_t* qubo = sparse_qubo_create(3, 5, rows, cols, values);
+
+    EXPECT_DOUBLE_EQ(6, qubo->diagonal[1]);
+    ASSERT_EQ(2, qubo->row_start[1]);
+    ASSERT_EQ(3, qubo->row_start[2]);
+    ASSERT_EQ(4, qubo->row_start[3]);
+    EXPECT_EQ(1, qubo->columns[0]);
+    EXPECT_DOUBLE_EQ(5, qubo->values[0]);
+    EXPECT_EQ(2, qubo->columns[1]);
+    EXPECT_DOUBLE_EQ(2, qubo->values[1]);
+    EXPECT_EQ(0, qubo->columns[3]);
+    EXPECT_DOUBLE_EQ(2, qubo->values[3]);
+    sparse_qubo_free(qubo);
+}
+
+// Entries out of range or below the diagonal are refused
+TEST(sparse_qubo, bad_entries) {
+    int32_t rows[] = {0, 2, -1, 1};
+    int32_t cols[] = {1, 1, 0, 3};
+    double values[] = {1, 1, 1, 1};
+    for (int k = 1; k < 4; k++) {
+        int32_t row[] = {rows[0], rows[k]}, col[] = {cols[0], cols[k]};
+        EXPECT_EQ(NULL, sparse_qubo_create(3, 2, row, col, values));
+    }
+    sparse_qubo_t* qubo = sparse_qubo_create(3, 1, rows, cols, values);
+    EXPECT_NE((sparse_qubo_t*)NULL, qubo);
+    sparse_qubo_free(qubo);
+}
+
+TEST(sparse_qubo, evaluate_matches_dense) {
+    const int size = 30;
+    double** dense = (double**)malloc2D(size, size, sizeof(double));
+    int32_t rows[size * size], cols[size * size];
+    double values[size * size];
+    int64_t num_entries;
+    randomQubo(size, 7, dense, sparseValues, false);
+    quboEntries(size, dense, rows, cols, values, &num_entries);
+    sparse_qubo_t* sparse = sparse_qubo_create(size, num_entries, rows, cols, values);
+
+    int8_t dense_solution[size], sparse_solution[size];
+    double dense_flip_cost[size], sparse_flip_cost[size];
+    randomize_solution(dense_solution, size);
+    for (int i = 0; i < size; i++) sparse_solution[i] = dense_solution[i];
+
+    double dense_energy = evaluate(dense_solution, size, (const double**)dense, dense_flip_cost);
+    double sparse_energy = evaluate_sparse(sparse_solution, sparse, sparse_flip_cost);
+    ASSERT_DOUBLE_EQ(dense_energy, sparse_energy);
+    ASSERT_DOUBLE_EQ(Simple_evaluate(dense_solution, size, (const double**)dense), sparse_energy);
+    for (int i = 0; i < size; i++) ASSERT_DOUBLE_EQ(dense_flip_cost[i], sparse_flip_cost[i]);
+
+    // flipping bits one at a time has to track the full evaluation
+    for (int step = 0; step < 100; step++) {
+        uint bit = (step * 7) % size;
+        dense_energy = evaluate_1bit(dense_energy, bit, dense_solution, size, (const double**)dense, dense_flip_cost);
+        sparse_energy = evaluate_1bit_sparse(sparse_energy, bit, sparse_solution, sparse, sparse_flip_cost);
+        ASSERT_DOUBLE_EQ(dense_energy, sparse_energy);
+        for (int i = 0; i < size; i++) ASSERT_DOUBLE_EQ(dense_flip_cost[i], sparse_flip_cost[i]);
+    }
+    ASSERT_DOUBLE_EQ(Simple_evaluate(sparse_solution, size, (const double**)dense), sparse_energy);
+
+    sparse_qubo_free(sparse);
+    free(dense);
+}
+
+TEST(sparse_qubo, reduce_matches_dense) {
+    const int size = 30;
+    const int sub_size = 6;
+    double** dense = (double**)malloc2D(size, size, sizeof(double));
+    int32_t rows[size * size], cols[size * size];
+    double values[size * size];
+    int64_t num_entries;
+    randomQubo(size, 11, dense, sparseValues, false);
+    quboEntries(size, dense, rows, cols, values, &num_entries);
+    sparse_qubo_t* sparse = sparse_qubo_create(size, num_entries, rows, cols, values);
+
+    int selectionMapping[sub_size] = {0, 3, 4, 17, 28, 29};
+    int8_t globalState[size];
+    int8_t dense_state[sub_size], sparse_state[sub_size];
+    double** dense_sub = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+    double** sparse_sub = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+
+    randomize_solution(globalState, size);
+    reduce(selectionMapping, dense, sub_size, size, dense_sub, globalState, dense_state);
+    reduce_sparse(selectionMapping, sparse, sub_size, sparse_sub, globalState, sparse_state);
+
+    for (int i = 0; i < sub_size; i++) {
+        EXPECT_EQ(dense_state[i], sparse_state[i]);
+        for (int j = i; j < sub_size; j++) ASSERT_DOUBLE_EQ(dense_sub[i][j], sparse_sub[i][j]);
+    }
+
+    free(sparse_sub);
+    free(dense_sub);
+    sparse_qubo_free(sparse);
+    free(dense);
+}
+
+TEST(sparse_qubo, tabu_search_move_tree) {
+    const int size = 60;
+    double** dense = (double**)malloc2D(size, size, sizeof(double));
+    int32_t rows[size * size], cols[size * size];
+    double values[size * size];
+    int64_t num_entries;
+    randomQubo(size, 13, dense, sparseValues, false);
+    quboEntries(size, dense, rows, cols, values, &num_entries);
+    sparse_qubo_t* sparse = sparse_qubo_create(size, num_entries, rows, cols, values);
+    qubo_matrix_t matrix = {QUBO_SPARSE, size, NULL, NULL, NULL, sparse};
+
+    int8_t solution[size], best[size];
+    double flip_cost[size];
+    int TabuK[size], index[size], order[size];
+    for (int i = 0; i < size; i++) index[i] = i;
+    randomize_solution(solution, size);
+
+    struct move_tree* tree = move_tree_create(size);
+    int64_t bit_flips = 0;
+    qbsolv_context_t ctx = default_context();
+    double energy = tabu_search(&ctx, solution, best, &matrix, flip_cost, &bit_flips, 20000, TabuK, 0, false, index,
+                                0, order, tree, NULL);
+
+    // the returned state is the evaluated best one, and a local optimum
+    ASSERT_DOUBLE_EQ(Simple_evaluate(solution, size, (const double**)dense), energy);
+    for (int i = 0; i < size; i++) {
+        EXPECT_EQ(best[i], solution[i]);
+        EXPECT_LE(flip_cost[i], 1e-9);
+    }
+
+    move_tree_free(tree);
+    sparse_qubo_free(sparse);
+    free(dense);
+}
@@ -0,0 +1,64 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+// The specialized kernels must follow the generic search exactly, including its random draws
+static void checkSize(int size) {
+    solver_workspace_t* work = solver_workspace_create(size, size);
+    randomQubo(size, 3 + size, work->sub_qubo, thirdValues, false);
+
+    int8_t* start = (int8_t*)malloc(size);
+    int8_t* generic = (int8_t*)malloc(size);
+    int8_t* fixed = (int8_t*)malloc(size);
+    randomize_solution(start, size);
+
+    for (int i = 0; i < size; i++) {
+        generic[i] = start[i];
+        fixed[i] = start[i];
+        work->sub_tabu[i] = 0;
+        work->sub_index[i] = i;
+        work->sub_best[i] = start[i];
+    }
+
+    qbsolv_context_t ctx = default_context();
+    solver_rng_t rng;
+    solver_rng_seed(&rng, 17);
+    solver_rand_stream(&rng);
+    int64_t bit_flips = 0;
+    qubo_matrix_t matrix = dense_qubo_matrix(work->sub_qubo, size);
+    solv_submatrix(&ctx, generic, work->sub_best, &matrix, work->sub_flip_cost, &bit_flips, work->sub_tabu,
+                   work->sub_index, work->sub_order);
+    uint64_t generic_next = solver_rand64();
+
+    solver_rng_seed(&rng, 17);
+    ASSERT_TRUE(tabu_sub_solve_fixed(&ctx, work->sub_qubo, size, fixed));
+    uint64_t fixed_next = solver_rand64();
+    solver_rand_stream(NULL);
+
+    for (int i = 0; i < size; i++) EXPECT_EQ(generic[i], fixed[i]);
+    EXPECT_EQ(generic_next, fixed_next);
+
+    free(fixed);
+    free(generic);
+    free(start);
+    solver_workspace_free(work);
+}
+
+TEST(sub_solver, fixed_32_matches_generic) { checkSize(32); }
+
+TEST(sub_solver, fixed_47_matches_generic) { checkSize(47); }
+
+TEST(sub_solver, fixed_64_matches_generic) { checkSize(64); }
+
+TEST(sub_solver, other_sizes_not_handled) {
+    double** qubo = (double**)malloc2D_aligned(40, 40, sizeof(double));
+    randomQubo(40, 5, qubo, thirdValues, false);
+    int8_t solution[40] = {0};
+    qbsolv_context_t ctx = default_context();
+    EXPECT_FALSE(tabu_sub_solve_fixed(&ctx, qubo, 40, solution));
+    for (int i = 0; i < 40; i++) EXPECT_EQ(0, solution[i]);
+    free(qubo);
+}
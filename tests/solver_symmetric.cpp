@@ -0,0 +1,79 @@
+#include "extern.h"
+#include "gtest/gtest.h"
+#include "qbsolv.h"
+#include "solver.h"
+#include "test_qubos.h"
+#include "util.h"
+
+TEST(symmetric_qubo, mirror) {
+    double** qubo = (double**)malloc2D(3, 3, sizeof(double));
+    randomQubo(3, 3, qubo, halfValues, true);
+    symmetrize_qubo(qubo, 3);
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) EXPECT_DOUBLE_EQ(qubo[i][j], qubo[j][i]);
+    }
+    free(qubo);
+}
+
+TEST(symmetric_qubo, evaluate_matches_dense) {
+    const int size = 40;
+    double** dense = (double**)malloc2D(size, size, sizeof(double));
+    double** symmetric = (double**)malloc2D(size, size, sizeof(double));
+    randomQubo(size, 5, dense, halfValues, true);
+    randomQubo(size, 5, symmetric, halfValues, true);
+    symmetrize_qubo(symmetric, size);
+
+    int8_t dense_solution[size], symmetric_solution[size];
+    double dense_flip_cost[size], symmetric_flip_cost[size];
+    randomize_solution(dense_solution, size);
+    for (int i = 0; i < size; i++) symmetric_solution[i] = dense_solution[i];
+
+    double dense_energy = evaluate(dense_solution, size, (const double**)dense, dense_flip_cost);
+    double symmetric_energy = evaluate_symmetric(symmetric_solution, size, (const double**)symmetric,
+                                                 symmetric_flip_cost);
+    ASSERT_DOUBLE_EQ(dense_energy, symmetric_energy);
+    for (int i = 0; i < size; i++) ASSERT_DOUBLE_EQ(dense_flip_cost[i], symmetric_flip_cost[i]);
+
+    for (int step = 0; step < 100; step++) {
+        uint bit = (step * 13) % size;
+        dense_energy = evaluate_1bit(dense_energy, bit, dense_solution, size, (const double**)dense, dense_flip_cost);
+        symmetric_energy = evaluate_1bit_symmetric(symmetric_energy, bit, symmetric_solution, size,
+                                                   (const double**)symmetric, symmetric_flip_cost);
+        ASSERT_DOUBLE_EQ(dense_energy, symmetric_energy);
+        for (int i = 0; i < size; i++) ASSERT_DOUBLE_EQ(dense_flip_cost[i], symmetric_flip_cost[i]);
+    }
+
+    free(symmetric);
+    free(dense);
+}
+
+TEST(symmetric_qubo, reduce_matches_dense) {
+    const int size = 40;
+    const int sub_size = 5;
+    double** dense = (double**)malloc2D(size, size, sizeof(double));
+    double** symmetric = (double**)malloc2D(size, size, sizeof(double));
+    randomQubo(size, 9, dense, halfValues, true);
+    randomQubo(size, 9, symmetric, halfValues, true);
+    symmetrize_qubo(symmetric, size);
+
+    int selectionMapping[sub_size] = {1, 2, 20, 33, 39};
+    int8_t globalState[size];
+    int8_t dense_state[sub_size], symmetric_state[sub_size];
+    double** dense_sub = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+    double** symmetric_sub = (double**)malloc2D(sub_size, sub_size, sizeof(double));
+
+    randomize_solution(globalState, size);
+    reduce(selectionMapping, dense, sub_size, size, dense_sub, globalState, dense_state);
+    reduce_symmetric(selectionMapping, symmetric, sub_size, size, symmetric_sub, globalState, symmetric_state);
+
+    for (int i = 0; i < sub_size; i++) {
+        EXPECT_EQ(dense_state[i], symmetric_state[i]);
+        for (int j = i; j < sub_size; j++) ASSERT_DOUBLE_EQ(dense_sub[i][j], symmetric_sub[i][j]);
+    }
+
+    free(symmetric_sub);
+    free(dense_sub);
+    free(symmetric);
+    free(dense);
+}
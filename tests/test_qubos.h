@@ -0,0 +1,58 @@
+// The pseudo random QUBOs of the tests and benchmarks, so every file draws them the same way
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// How the coefficients of a random QUBO are drawn: integers in [-range, range], divided by divisor
+// and shifted by offset, the diagonal always and each coupler with a chance of one in one_in
+struct QuboValues {
+    int range;
+    double divisor;
+    double offset;
+    int one_in;
+};
+
+// integers in [-1000, 1000], the values of the integer layout
+static const QuboValues integerValues = {1000, 1.0, 0.0, 1};
+// thirds of integers in [-1000, 1000], that are not exact in binary so that reordered sums show up
+static const QuboValues thirdValues = {1000, 3.0, 0.0, 1};
+// halves in [-9.5, 10.5], exact in binary so that reordered sums do not show up
+static const QuboValues halfValues = {10, 1.0, 0.5, 1};
+// quarters in [-9.75, 10.25] for roughly half of the couplers, never zero
+static const QuboValues sparseValues = {10, 1.0, 0.25, 2};
+// A Beasley bqp style problem: 10% density, integer coefficients in [-100, 100]
+static const QuboValues bqpValues = {100, 1.0, 0.0, 10};
+
+// Fill the upper triangle of a size x size qubo with coefficients drawn from seed as values says
+//
+// @param full true for a full matrix, whose lower triangle is zeroed, false for a triangular one
+//      (malloc2D_triangular), whose lower triangle is not there
+static inline void randomQubo(int size, unsigned seed, double **qubo, const QuboValues &values, bool full) {
+    srand(seed);
+    for (int i = 0; i < size; i++) {
+        if (full) {
+            for (int j = 0; j < i; j++) qubo[i][j] = 0.0;
+        }
+        for (int j = i; j < size; j++) {
+            qubo[i][j] = 0.0;
+            if (i != j && values.one_in > 1 && rand() % values.one_in != 0) continue;
+            qubo[i][j] = ((rand() % (2 * values.range + 1)) - values.range) / values.divisor + values.offset;
+        }
+    }
+}
+
+// List the diagonal and the nonzero couplers of the upper triangle of qubo as entries for
+// sparse_qubo_create, size * (size + 1) / 2 of them at most
+static inline void quboEntries(int size, double **qubo, int32_t *rows, int32_t *cols, double *values,
+                               int64_t *num_entries) {
+    *num_entries = 0;
+    for (int i = 0; i < size; i++) {
+        for (int j = i; j < size; j++) {
+            if (i != j && qubo[i][j] == 0.0) continue;
+            rows[*num_entries] = i;
+            cols[*num_entries] = j;
+            values[(*num_entries)++] = qubo[i][j];
+        }
+    }
+}
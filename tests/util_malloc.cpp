@@ -91,3 +91,87 @@ TEST(util_malloc, types) {
     checkMatrix<double>(5, 1);
     checkMatrix<double>(5, 5);
 }
+
+template <class Type>
+void checkTriangular(size_t size) {
+    // Allocate
+    Type** matrix = (Type**)malloc2D_triangular(size, sizeof(Type));
+
+    // Fill the upper triangle with predictable numbers
+    int counter = 0;
+    for (size_t rr = 0; rr < size; rr++) {
+        for (size_t cc = rr; cc < size; cc++) {
+            matrix[rr][cc] = counter++;
+        }
+    }
+
+    // Only the upper triangle is stored, row after row, without any overlap
+    counter = 0;
+    for (size_t rr = 0; rr < size; rr++) {
+        for (size_t cc = rr; cc < size; cc++) {
+            EXPECT_EQ(matrix[rr][cc], (Type)counter++);
+        }
+        if (rr > 0) {
+            EXPECT_LT((void*)&matrix[rr - 1][size - 1], (void*)&matrix[rr][rr]);
+        }
+    }
+
+    // Every row is placed as if column zero was on an alignment boundary
+    for (size_t rr = 0; rr < size; rr++) {
+        EXPECT_EQ(0u, (uintptr_t)matrix[rr] % MATRIX_ALIGN);
+    }
+
+    // The data follows the lookup table
+    char** lookup = (char**)matrix;
+    EXPECT_LE((void*)(lookup + size), (void*)&matrix[0][0]);
+    free(matrix);
+}
+
+template <class Type>
+void checkAligned(size_t rows, size_t cols) {
+    // Allocate
+    Type** matrix = (Type**)malloc2D_aligned(rows, cols, sizeof(Type));
+
+    // Fill the matrix with predictable numbers
+    int counter = 0;
+    for (size_t rr = 0; rr < rows; rr++) {
+        for (size_t cc = 0; cc < cols; cc++) {
+            matrix[rr][cc] = counter++;
+        }
+    }
+
+    // Rows are aligned, padded to the same stride, and do not overlap
+    counter = 0;
+    for (size_t rr = 0; rr < rows; rr++) {
+        EXPECT_EQ(0u, (uintptr_t)matrix[rr] % MATRIX_ALIGN);
+        if (rr > 0) {
+            EXPECT_EQ((char*)matrix[1] - (char*)matrix[0], (char*)matrix[rr] - (char*)matrix[rr - 1]);
+            EXPECT_LE(cols * sizeof(Type), (size_t)((char*)matrix[rr] - (char*)matrix[rr - 1]));
+        }
+        for (size_t cc = 0; cc < cols; cc++) {
+            EXPECT_EQ(matrix[rr][cc], (Type)counter++);
+        }
+    }
+    free(matrix);
+}
+
+TEST(util_malloc, triangular) {
+    checkTriangular<uint8_t>(1);
+    checkTriangular<uint8_t>(7);
+    checkTriangular<uint32_t>(1);
+    checkTriangular<uint32_t>(2);
+    checkTriangular<uint32_t>(5);
+    checkTriangular<uint32_t>(100);
+    checkTriangular<double>(5);
+    checkTriangular<double>(100);
+}
+
+TEST(util_malloc, aligned) {
+    checkAligned<uint8_t>(1, 1);
+    checkAligned<uint8_t>(7, 65);
+    checkAligned<int32_t>(5, 5);
+    checkAligned<float>(100, 100);
+    checkAligned<double>(1, 5);
+    checkAligned<double>(10, 100);
+    checkAligned<double>(100, 10);
+}
@@ -0,0 +1,66 @@
+#include "../src/extern.h"
+#include "../src/util.h"
+#include "gtest/gtest.h"
+
+// The unmasked variable with the largest cost, lowest on ties, by a full scan
+static int bestByScan(const double* cost, const int8_t* masked, int size) {
+    int best = -1;
+    for (int i = 0; i < size; i++) {
+        if (masked[i]) continue;
+        if (best < 0 || cost[i] > cost[best]) best = i;
+    }
+    return best;
+}
+
+TEST(move_tree, matches_scan) {
+    for (int size : {1, 2, 7, 64, 100}) {
+        double* cost = (double*)malloc(size * sizeof(double));
+        int8_t* masked = (int8_t*)malloc(size);
+        srand(5 + size);
+        for (int i = 0; i < size; i++) {
+            cost[i] = rand() % 50;  // plenty of ties
+            masked[i] = 0;
+        }
+
+        struct move_tree* tree = move_tree_create(size);
+        move_tree_build(tree, cost);
+        ASSERT_EQ(bestByScan(cost, masked, size), move_tree_best(tree));
+
+        for (int step = 0; step < 500; step++) {
+            int i = rand() % size;
+            if (rand() % 2) {
+                cost[i] = rand() % 50;
+                move_tree_update(tree, i);
+            } else {
+                masked[i] = !masked[i];
+                move_tree_set_masked(tree, i, masked[i]);
+            }
+            ASSERT_EQ(bestByScan(cost, masked, size), move_tree_best(tree));
+
+            int masked_count = 0;
+            for (int j = 0; j < size; j++) masked_count += masked[j];
+            ASSERT_EQ(masked_count, tree->masked_count);
+        }
+
+        // a rebuild keeps the masks
+        for (int j = 0; j < size; j++) cost[j] = -cost[j];
+        move_tree_build(tree, cost);
+        ASSERT_EQ(bestByScan(cost, masked, size), move_tree_best(tree));
+
+        move_tree_free(tree);
+        free(masked);
+        free(cost);
+    }
+}
+
+TEST(move_tree, all_masked) {
+    double cost[3] = {1.0, 2.0, 3.0};
+    struct move_tree* tree = move_tree_create(3);
+    move_tree_build(tree, cost);
+    EXPECT_EQ(2, move_tree_best(tree));
+    for (int i = 0; i < 3; i++) move_tree_set_masked(tree, i, true);
+    EXPECT_EQ(-1, move_tree_best(tree));
+    move_tree_set_masked(tree, 0, false);
+    EXPECT_EQ(0, move_tree_best(tree));
+    move_tree_free(tree);
+}
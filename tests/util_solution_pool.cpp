@@ -0,0 +1,98 @@
+#include "../src/extern.h"
+#include "../include/qbsolv.h"
+#include "../src/util.h"
+#include "gtest/gtest.h"
+
+TEST(solution_pool, pack_and_distance) {
+    const int nbits = 130;
+    int8_t a[nbits], b[nbits];
+    struct solution_pool* pool = solution_pool_create(3, nbits);
+    ASSERT_EQ(3, pool->words);
+
+    srand(3);
+    randomize_solution(a, nbits);
+    for (int i = 0; i < nbits; i++) b[i] = a[i];
+    solution_pool_store(pool, 0, a);
+    solution_pool_store(pool, 1, b);
+    EXPECT_EQ(pool->hash[0], pool->hash[1]);
+    EXPECT_EQ(0, packed_solution_distance(pool->bits[0], pool->bits[1], pool->words));
+
+    // bits on both sides of the word boundaries
+    for (int i : {0, 63, 64, 129}) {
+        EXPECT_EQ(a[i], (int8_t)((pool->bits[0][i / 64] >> (i % 64)) & 1));
+        b[i] = 1 - b[i];
+    }
+    solution_pool_store(pool, 1, b);
+    EXPECT_NE(pool->hash[0], pool->hash[1]);
+    EXPECT_EQ(4, packed_solution_distance(pool->bits[0], pool->bits[1], pool->words));
+
+    solution_pool_free(pool);
+}
+
+TEST(solution_pool, index_diff_matches_unpacked) {
+    const int nbits = 200, nsol = 7;
+    int8_t** solution_list = (int8_t**)malloc2D(nsol, nbits, sizeof(int8_t));
+    struct solution_pool* pool = solution_pool_create(nsol, nbits);
+    int sol_index[nsol], index[nbits], packed_index[nbits];
+
+    srand(5);
+    for (int j = 0; j < nsol; j++) {
+        // mostly agreeing solutions, so there is a backbone to find
+        for (int i = 0; i < nbits; i++) solution_list[j][i] = (i % 3 == 0) ? rand() % 2 : i % 2;
+        solution_pool_store(pool, j, solution_list[j]);
+        sol_index[j] = nsol - 1 - j;
+    }
+
+    for (int delta_bits = 0; delta_bits < 3; delta_bits++) {
+        for (int num_solutions = 1; num_solutions <= nsol; num_solutions++) {
+            int ndiff = mul_index_solution_diff(solution_list, num_solutions, nbits, index, delta_bits, sol_index);
+            int packed_ndiff = pool_index_solution_diff(pool, num_solutions, packed_index, delta_bits, sol_index);
+            ASSERT_EQ(ndiff, packed_ndiff);
+            for (int i = 0; i < nbits; i++) ASSERT_EQ(index[i], packed_index[i]);
+        }
+    }
+
+    solution_pool_free(pool);
+    free(solution_list);
+}
+
+TEST(solution_pool, manage_solutions_duplicates) {
+    const int nbits = 70, nMax = 4;
+    int8_t** solution_list = (int8_t**)malloc2D(nMax + 1, nbits, sizeof(int8_t));
+    double energy_list[nMax + 1];
+    int solution_counts[nMax + 1], list_order[nMax + 1], num_nq_solutions = 0;
+    struct solution_pool* pool = solution_pool_create(nMax + 1, nbits);
+    for (int i = 0; i < nMax + 1; i++) {
+        energy_list[i] = BIGNEGFP;
+        solution_counts[i] = 0;
+        list_order[i] = i;
+    }
+
+    int8_t a[nbits], b[nbits];
+    srand(7);
+    randomize_solution(a, nbits);
+    for (int i = 0; i < nbits; i++) b[i] = a[i];
+    b[65] = 1 - b[65];
+
+    qbsolv_context_t ctx = qbsolv_context_t();  // quiet
+    struct sol_man_rslt result;
+    result = manage_solutions(&ctx, a, solution_list, 10.0, energy_list, solution_counts, list_order, nMax,
+                              nbits, &num_nq_solutions, pool);
+    EXPECT_EQ(NEW_HIGH_ENERGY_UNIQUE_SOL, result.code);
+
+    // same energy, different solution
+    result = manage_solutions(&ctx, b, solution_list, 10.0, energy_list, solution_counts, list_order, nMax,
+                              nbits, &num_nq_solutions, pool);
+    EXPECT_EQ(DUPLICATE_HIGHEST_ENERGY, result.code);
+    EXPECT_EQ(2, num_nq_solutions);
+
+    // the first one again
+    result = manage_solutions(&ctx, a, solution_list, 10.0, energy_list, solution_counts, list_order, nMax,
+                              nbits, &num_nq_solutions, pool);
+    EXPECT_EQ(DUPLICATE_HIGHEST_ENERGY, result.code);
+    EXPECT_EQ(2, num_nq_solutions);
+    EXPECT_EQ(3, solution_counts[0] + solution_counts[1] + solution_counts[2] + solution_counts[3]);
+
+    solution_pool_free(pool);
+    free(solution_list);
+}